@@ -0,0 +1,291 @@
+// Benchmarks for CityGraph: how fast are we with 1k, 10k, 100k or 1M cities?
+// Runs without any menus, straight against the CityGraph functions.
+//
+// Build: g++ -std=c++17 -O2 -pthread bench.cpp -o bench
+// Run:   ./bench [--sizes 1000,10000,100000,1000000] [--seed 42] [--out bench_results]
+// Writes <out>.json and <out>.csv so runs can be compared to catch slowdowns.
+#include "city_graph.h" // The road network manager we're timing
+#include <random> // Seeded generator, so every run builds the same networks
+#include <memory> // unique_ptr for timing load-from-disk
+
+// A made-up road network: city names plus roads between their positions in the list
+struct GeneratedNetwork {
+    vector<string> names;
+    vector<PlannedRoad> roads; // a and b are positions in names, not city IDs
+    vector<pair<double, double>> positions; // Latitude and longitude of each city
+};
+
+// Build a network that looks like real roads: cities scattered over a Rwanda-sized
+// area (250 x 105 km), each linked to its nearest neighbors, budgets based on distance
+GeneratedNetwork generateNetwork(int cityCount, uint64_t seed) {
+    GeneratedNetwork network;
+    mt19937_64 random(seed);
+    uniform_real_distribution<double> xs(0.0, 250.0), ys(0.0, 105.0), costPerKm(0.3, 1.2);
+    const char *syllables[] = {"ka", "ru", "mu", "nya", "gi", "ba", "ki", "ga", "hu", "ye", "sa", "ze", "ngo", "bu"};
+
+    vector<double> x(cityCount), y(cityCount);
+    network.names.reserve(cityCount);
+    for (int i = 0; i < cityCount; ++i) {
+        x[i] = xs(random);
+        y[i] = ys(random);
+        // Rwanda's south-west corner is near -2.84, 28.86; a degree is about 111 km
+        network.positions.emplace_back(-2.84 + y[i] / 111.0, 28.86 + x[i] / (111.0 * cos(2.3 * DEGREES)));
+        string name;
+        for (int part = 0; part < 3; ++part) name += syllables[random() % 14];
+        name[0] = static_cast<char>(toupper(name[0]));
+        network.names.push_back(name + "-" + to_string(i)); // The number keeps names unique
+    }
+
+    // Drop cities into a grid with about 2 per cell, then look for neighbors nearby
+    double cell = sqrt(250.0 * 105.0 * 2.0 / max(cityCount, 1));
+    int columns = static_cast<int>(250.0 / cell) + 1, rows = static_cast<int>(105.0 / cell) + 1;
+    vector<vector<int>> grid(static_cast<size_t>(columns) * rows);
+    auto cellOf = [&](int i) { return static_cast<int>(y[i] / cell) * columns + static_cast<int>(x[i] / cell); };
+    for (int i = 0; i < cityCount; ++i) grid[cellOf(i)].push_back(i);
+
+    const int NEIGHBORS = 2; // Each city gets a road to its 2 closest cities
+    vector<pair<int, int>> links;
+    for (int i = 0; i < cityCount; ++i) {
+        vector<pair<double, int>> nearby;
+        int cx = static_cast<int>(x[i] / cell), cy = static_cast<int>(y[i] / cell);
+        for (int reach = 1; nearby.size() < NEIGHBORS && reach <= max(columns, rows); ++reach) {
+            nearby.clear();
+            for (int gy = max(0, cy - reach); gy <= min(rows - 1, cy + reach); ++gy) {
+                for (int gx = max(0, cx - reach); gx <= min(columns - 1, cx + reach); ++gx) {
+                    for (int j : grid[static_cast<size_t>(gy) * columns + gx]) {
+                        if (j != i) nearby.emplace_back(hypot(x[i] - x[j], y[i] - y[j]), j);
+                    }
+                }
+            }
+        }
+        size_t keep = min<size_t>(NEIGHBORS, nearby.size());
+        partial_sort(nearby.begin(), nearby.begin() + keep, nearby.end());
+        for (size_t k = 0; k < keep; ++k) links.emplace_back(min(i, nearby[k].second), max(i, nearby[k].second));
+    }
+    // Two cities often pick each other, keep that road once
+    sort(links.begin(), links.end());
+    links.erase(unique(links.begin(), links.end()), links.end());
+    network.roads.reserve(links.size());
+    for (const auto &link : links) {
+        double km = hypot(x[link.first] - x[link.second], y[link.first] - y[link.second]);
+        network.roads.push_back({link.first, link.second, round(km * costPerKm(random) * 100.0) / 100.0});
+    }
+    return network;
+}
+
+// One timed measurement
+struct BenchResult {
+    int cities;
+    string operation;
+    size_t ops;
+    double seconds;
+};
+
+// Time work(), which does `ops` operations
+template <typename Work>
+BenchResult measure(int cities, const string &operation, size_t ops, Work work) {
+    auto start = chrono::steady_clock::now();
+    work();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    BenchResult result{cities, operation, ops, seconds};
+    cout << "  " << left << setw(20) << operation << right << setw(10) << ops << " ops "
+         << fixed << setprecision(4) << setw(10) << seconds << " s "
+         << setprecision(1) << setw(12) << (seconds > 0 ? ops / seconds : 0.0) << " ops/sec\n";
+    return result;
+}
+
+// Run every benchmark for one network size, inside its own empty data folder
+void runSize(int cityCount, uint64_t seed, vector<BenchResult> &results) {
+    cout << "\n=== " << cityCount << " cities ===\n";
+    GeneratedNetwork generated = generateNetwork(cityCount, seed);
+    cout << "  (generated " << generated.roads.size() << " roads)\n";
+
+    filesystem::path home = filesystem::current_path();
+    filesystem::path folder = filesystem::temp_directory_path() / ("citygraph_bench_" + to_string(cityCount));
+    filesystem::remove_all(folder);
+    filesystem::create_directories(folder);
+    filesystem::current_path(folder); // CityGraph keeps its files in the current folder
+
+    {
+        CityGraph graph;
+        vector<int> ids(generated.names.size());
+        graph.beginBulk(generated.names.size());
+        results.push_back(measure(cityCount, "insert_cities", generated.names.size(), [&] {
+            for (size_t i = 0; i < generated.names.size(); ++i) graph.insertCity(generated.names[i], ids[i]);
+        }));
+        results.push_back(measure(cityCount, "insert_roads", generated.roads.size(), [&] {
+            for (const PlannedRoad &road : generated.roads) {
+                graph.connectCities(ids[road.a], ids[road.b]);
+                graph.assignBudget(ids[road.a], ids[road.b], road.budget);
+            }
+        }));
+        results.push_back(measure(cityCount, "set_locations", generated.positions.size(), [&] {
+            for (size_t i = 0; i < generated.positions.size(); ++i) {
+                graph.setLocation(ids[i], generated.positions[i].first, generated.positions[i].second);
+            }
+        }));
+        graph.endBulk();
+        results.push_back(measure(cityCount, "save", 1, [&] {
+            graph.saveData();
+            graph.flushSaves(); // Time the whole write, not just handing it over
+        }));
+
+        // Look up random names that exist
+        const size_t LOOKUPS = 100000;
+        mt19937_64 random(seed + 1);
+        vector<const string *> wanted(LOOKUPS);
+        for (auto &name : wanted) name = &generated.names[random() % generated.names.size()];
+        size_t found = 0;
+        results.push_back(measure(cityCount, "name_lookup", LOOKUPS, [&] {
+            for (const string *name : wanted) found += graph.findCityByName(*name) != -1;
+        }));
+        if (found != LOOKUPS) cout << "  Warning: only " << found << " of " << LOOKUPS << " names found\n";
+
+        // Display paths, rendered into a buffer that never gets printed
+        results.push_back(measure(cityCount, "display_cities", 1, [&] {
+            ScreenBuffer out;
+            graph.renderCities(out, 0, INT_MAX);
+        }));
+        results.push_back(measure(cityCount, "display_matrix_100", 1, [&] {
+            ScreenBuffer out;
+            graph.renderMatrix(out, {ids[0], ids[0] + 99, ids[0], ids[0] + 99}, true);
+        }));
+        results.push_back(measure(cityCount, "display_road_list", 1, [&] {
+            ScreenBuffer out;
+            graph.renderRoadList(out);
+        }));
+
+        // Nearby searches around random cities, through the k-d tree
+        const size_t NEARBY = 10000;
+        size_t nearby = 0;
+        results.push_back(measure(cityCount, "locator_build", 1, [&] { graph.refreshLocator(); }));
+        results.push_back(measure(cityCount, "nearest_10", NEARBY, [&] {
+            for (size_t q = 0; q < NEARBY; ++q) {
+                const auto &at = generated.positions[random() % generated.positions.size()];
+                nearby += graph.nearestCities(at.first, at.second, 10).size();
+            }
+        }));
+        results.push_back(measure(cityCount, "within_5km", NEARBY, [&] {
+            for (size_t q = 0; q < NEARBY; ++q) {
+                const auto &at = generated.positions[random() % generated.positions.size()];
+                nearby += graph.citiesWithin(at.first, at.second, 5.0).size();
+            }
+        }));
+        if (nearby == 0) cout << "  Warning: nearby searches found nothing\n";
+
+        // Cheapest routes between random cities: plain Dijkstra, A* and the contraction hierarchy.
+        // Dijkstra and A* get the same pairs, and must agree on the cost.
+        const size_t DIJKSTRA_ROUTES = 20, HIERARCHY_ROUTES = 10000;
+        vector<pair<int, int>> pairs(DIJKSTRA_ROUTES);
+        for (auto &ends : pairs) ends = {ids[random() % ids.size()], ids[random() % ids.size()]};
+        vector<int> path;
+        vector<double> plain, guided;
+        double total = 0.0;
+        results.push_back(measure(cityCount, "route_dijkstra", DIJKSTRA_ROUTES, [&] {
+            for (const auto &ends : pairs) plain.push_back(graph.cheapestRoute(ends.first, ends.second, path, "dijkstra"));
+        }));
+        graph.canGuessRoutes(); // Works out the A* cost-per-km bound once, not part of the timing
+        results.push_back(measure(cityCount, "route_astar", DIJKSTRA_ROUTES, [&] {
+            for (const auto &ends : pairs) guided.push_back(graph.cheapestRoute(ends.first, ends.second, path, "astar"));
+        }));
+        for (size_t q = 0; q < pairs.size(); ++q) {
+            if (abs(plain[q] - guided[q]) > 1e-6 * max(1.0, plain[q])) cout << "  Warning: A* and Dijkstra disagree on a route\n";
+            if (plain[q] != numeric_limits<double>::infinity()) total += plain[q];
+        }
+        // A city added after A* has run must still be routable, with and without roads
+        int late;
+        graph.insertCity("Bench Late City", late);
+        if (graph.cheapestRoute(ids[0], late, path, "astar") != numeric_limits<double>::infinity()) {
+            cout << "  Warning: A* found a route to a city with no roads\n";
+        }
+        graph.connectCities(ids[0], late);
+        graph.assignBudget(ids[0], late, 1.0);
+        graph.setLocation(late, generated.positions[0].first, generated.positions[0].second);
+        for (const auto &ends : pairs) {
+            double viaDijkstra = graph.cheapestRoute(ends.first, late, path, "dijkstra");
+            double viaAstar = graph.cheapestRoute(ends.first, late, path, "astar");
+            if (abs(viaDijkstra - viaAstar) > 1e-6 * max(1.0, viaDijkstra)) {
+                cout << "  Warning: A* and Dijkstra disagree on a route to a city added later\n";
+            }
+        }
+        bool hierarchyBuilt = false;
+        results.push_back(measure(cityCount, "hierarchy_build", 1, [&] { hierarchyBuilt = graph.refreshHierarchy(); }));
+        if (!hierarchyBuilt) cout << "  Warning: the hierarchy build gave up, its routes below are plain Dijkstra\n";
+        results.push_back(measure(cityCount, "route_hierarchy", HIERARCHY_ROUTES, [&] {
+            for (size_t q = 0; q < HIERARCHY_ROUTES; ++q) {
+                total += graph.cheapestRoute(ids[random() % ids.size()], ids[random() % ids.size()], path, "hierarchy");
+            }
+        }));
+        // The hierarchy must agree with Dijkstra on the same pairs as A* did
+        for (size_t q = 0; q < pairs.size(); ++q) {
+            double viaHierarchy = graph.cheapestRoute(pairs[q].first, pairs[q].second, path, "hierarchy");
+            if (abs(plain[q] - viaHierarchy) > 1e-6 * max(1.0, plain[q])) {
+                cout << "  Warning: the hierarchy and Dijkstra disagree on a route\n";
+            }
+        }
+        // A round of budget changes, then the rebuild that reuses the old order
+        graph.beginBulk(0);
+        for (size_t edit = 0; edit < 1000 && !generated.roads.empty(); ++edit) {
+            const PlannedRoad &road = generated.roads[random() % generated.roads.size()];
+            graph.assignBudget(ids[road.a], ids[road.b], road.budget * 1.1);
+        }
+        graph.endBulk();
+        results.push_back(measure(cityCount, "hierarchy_rebuild", 1, [&] { graph.refreshHierarchy(); }));
+        if (total < 0) cout << "  Warning: negative route cost\n"; // Keeps the routes from being optimized away
+    }
+
+    // Loading: once from the binary snapshot, once from the text files
+    unique_ptr<CityGraph> loaded;
+    results.push_back(measure(cityCount, "load_snapshot", 1, [&] { loaded = make_unique<CityGraph>(); }));
+    loaded.reset();
+    filesystem::remove("network.bin");
+    results.push_back(measure(cityCount, "load_text", 1, [&] { loaded = make_unique<CityGraph>(); }));
+    loaded.reset(); // Writes the snapshot back, not timed
+
+    filesystem::current_path(home);
+    filesystem::remove_all(folder);
+}
+
+// Save the results as JSON and CSV, one row per (size, operation)
+void writeResults(const vector<BenchResult> &results, const string &prefix) {
+    ofstream csv(prefix + ".csv");
+    csv << "cities,operation,ops,seconds,ops_per_sec\n";
+    ofstream json(prefix + ".json");
+    json << "[\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult &r = results[i];
+        double rate = r.seconds > 0 ? r.ops / r.seconds : 0.0;
+        csv << r.cities << "," << r.operation << "," << r.ops << "," << setprecision(9) << r.seconds << ","
+            << setprecision(1) << fixed << rate << defaultfloat << "\n";
+        json << "  {\"cities\": " << r.cities << ", \"operation\": \"" << r.operation << "\", \"ops\": " << r.ops
+             << ", \"seconds\": " << setprecision(9) << r.seconds << ", \"ops_per_sec\": "
+             << setprecision(1) << fixed << rate << defaultfloat << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    json << "]\n";
+    cout << "\nResults written to " << prefix << ".json and " << prefix << ".csv\n";
+}
+
+int main(int argc, char *argv[]) {
+    vector<int> sizes{1000, 10000, 100000, 1000000};
+    uint64_t seed = 42;
+    string out = "bench_results";
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string option = argv[i], value = argv[i + 1];
+        if (option == "--sizes") {
+            sizes.clear();
+            for (const string &size : splitFields(value)) sizes.push_back(stoi(size));
+        } else if (option == "--seed") {
+            seed = stoull(value);
+        } else if (option == "--out") {
+            out = value;
+        } else {
+            cout << "Unknown option " << option << "\n";
+            return 1;
+        }
+    }
+    out = filesystem::absolute(out).string(); // Before we start hopping between data folders
+    vector<BenchResult> results;
+    for (int size : sizes) runSize(size, seed, results);
+    writeResults(results, out);
+    return 0;
+}
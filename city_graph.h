@@ -0,0 +1,4013 @@
+// Everything behind the Rwanda Road Network Manager: cities, roads, budgets and the
+// CityGraph class that ties them together. Shared by the app (main.cpp) and the
+// benchmarks (bench.cpp).
+#ifndef CITY_GRAPH_H
+#define CITY_GRAPH_H
+
+#include <iostream> // For printing to the screen and getting user input
+#include <string> // For handling text like city names
+#include <unordered_map> // A fancy dictionary to store our cities
+#include <vector> // Lists that can grow, used for road connections
+#include <fstream> // For saving and loading files
+#include <sstream> // For splitting text in files
+#include <algorithm> // For some text cleanup tricks
+#include <limits> // To set limits on numbers
+#include <climits> // More number limits
+#include <iomanip> // For making our output look neat
+#include <cstdint> // Fixed-size numbers for checksums
+#include <filesystem> // For swapping in freshly written files safely
+#include <chrono> // For timing batch runs
+#include <deque> // Queue for the fewest-roads search
+#include <queue> // Priority queues for the contraction order and the top budgets
+#include <thread> // Worker threads for big network plans
+#include <atomic> // Lock-free "best road so far" slots shared by those threads
+#include <cstring> // memcpy for the binary snapshot
+#include <string_view> // Looking at text in place without copying it
+#include <charconv> // from_chars: the fastest way to read numbers out of text
+#include <array> // Fixed-size histogram buckets
+#include <map> // Sorted lookups for the administrative tree
+#include <memory> // shared_ptr for read-only snapshots
+#include <mutex> // The background saver and the editing thread take turns on its queue
+#include <condition_variable> // Wakes the saver when there's a checkpoint to write
+#include <cmath> // Trig for distances between map positions
+#ifndef _WIN32
+#include <fcntl.h> // open() for memory-mapping the snapshot
+#include <sys/mman.h> // mmap()
+#include <sys/stat.h> // fstat() to get the file size
+#include <unistd.h> // close()
+#endif
+
+using namespace std; // Makes it easier to use standard C++ stuff without extra typing
+
+// Yo, this function makes sure we get a proper number from the user, like picking a menu option!
+inline int readInt(const string &prompt, int minVal = INT_MIN, int maxVal = INT_MAX) {
+    while (true) { // Keep asking until we get it right
+        cout << prompt; // Show the question, like "Choose: "
+        string line;
+        if (!getline(cin, line)) { // Grab what the user types
+            cin.clear(); // Clear any input errors
+            continue; // Try again
+        }
+        try {
+            int val = stoi(line); // Turn text into a number
+            if (val < minVal || val > maxVal) { // Check if it's in the allowed range
+                cout << "Please enter a number";
+                if (minVal != INT_MIN && maxVal != INT_MAX)
+                    cout << " between " << minVal << " and " << maxVal; // Be specific if there's a range
+                cout << ".\n";
+                continue; // Nope, try again!
+            }
+            return val; // Sweet, we got a good number!
+        }
+        catch (...) {
+            cout << "Invalid input. Please enter a valid number.\n"; // No letters or weird stuff, please!
+        }
+    }
+}
+
+// Clean up extra spaces at the start or end, like trimming a haircut
+inline string trim(string input) {
+    input.erase(input.begin(), find_if(input.begin(), input.end(), [](unsigned char c) { return !isspace(c); }));
+    input.erase(find_if(input.rbegin(), input.rend(), [](unsigned char c) { return !isspace(c); }).base(), input.end());
+    return input;
+}
+
+// This grabs text input, like a city name, and makes sure it’s not blank or messy
+inline string readString(const string &prompt) {
+    string input;
+    while (true) {
+        cout << prompt; // Ask for input, like "City name: "
+        getline(cin, input); // Get the whole line they type
+        input = trim(input);
+        if (input.empty()) { // Nothing typed? Not cool!
+            cout << "Input cannot be empty.\n";
+        } else if (input.find(',') != string::npos) { // Commas mess up our files
+            cout << "Input cannot contain commas.\n";
+        } else {
+            return input; // Nice, we got a clean name!
+        }
+    }
+}
+
+// A simple way to store info about a city, like its ID and name
+struct City {
+    int index; // Unique number, like 1 for Kigali
+    string name; // The city’s name, like "Huye"
+    int area = -1; // Where it sits in the AdminTree (deepest unit known), -1 if nowhere yet
+    double latitude = NAN, longitude = NAN; // Position on the map in degrees, NAN until someone sets it
+
+    bool located() const { return !isnan(latitude); }
+};
+
+// All cities in one flat list where slot i holds city ID i, like numbered parking
+// spots. A deleted city leaves an empty spot (a tombstone, index -1) whose ID goes on
+// a free list, so the next new city can park there instead of growing the list.
+class CityTable {
+private:
+    vector<City> slots; // slots[i] is city i, or a tombstone
+    vector<int> freeIds; // Empty spots to reuse; checked again when taken
+    size_t live = 0; // Cities that really exist
+
+public:
+    bool has(int i) const { return i >= 0 && i < static_cast<int>(slots.size()) && slots[i].index != -1; }
+
+    City &operator[](int i) { return slots[i]; }
+    const City &at(int i) const { return slots[i]; }
+
+    size_t size() const { return live; } // Real cities only
+    int slotCount() const { return static_cast<int>(slots.size()); }
+
+    void reserve(size_t n) { slots.reserve(n); }
+
+    // Put (or rename) city i; any spots skipped on the way become holes
+    void put(int i, const string &name) {
+        while (slotCount() <= i) {
+            if (slotCount() > 0 && slotCount() < i) freeIds.push_back(slotCount()); // ID 0 is never handed out
+            slots.push_back({-1, ""});
+        }
+        if (slots[i].index == -1) {
+            live++;
+            slots[i] = {i, name};
+        } else {
+            slots[i].name = name; // Renamed, it stays in the same area
+        }
+    }
+
+    // Tombstone city i and remember its ID for later
+    void remove(int i) {
+        if (!has(i)) return;
+        slots[i] = {-1, ""};
+        freeIds.push_back(i);
+        live--;
+    }
+
+    // An empty ID to reuse, or -1 if there are no holes. Spots that got filled
+    // since they were freed (e.g. by a journal replay) are skipped.
+    int takeFreeId() {
+        while (!freeIds.empty()) {
+            int i = freeIds.back();
+            freeIds.pop_back();
+            if (i < slotCount() && slots[i].index == -1) return i;
+        }
+        return -1;
+    }
+
+    // Drop everything and start from these cities (used after renumbering)
+    void assign(vector<City> newSlots) {
+        slots = move(newSlots);
+        freeIds.clear();
+        live = 0;
+        for (const City &city : slots) live += city.index != -1;
+        for (int i = 1; i < slotCount(); ++i) {
+            if (slots[i].index == -1) freeIds.push_back(i);
+        }
+    }
+
+    size_t memoryBytes() const {
+        size_t bytes = slots.capacity() * sizeof(City) + freeIds.capacity() * sizeof(int);
+        for (const City &city : slots) bytes += city.name.capacity() > 15 ? city.name.capacity() + 1 : 0;
+        return bytes;
+    }
+
+    // Walk the real cities in ID order, hopping over tombstones
+    class iterator {
+    private:
+        const vector<City> *slots;
+        size_t at;
+        void skip() {
+            while (at < slots->size() && (*slots)[at].index == -1) ++at;
+        }
+
+    public:
+        iterator(const vector<City> *list, size_t start) : slots(list), at(start) { skip(); }
+        const City &operator*() const { return (*slots)[at]; }
+        iterator &operator++() {
+            ++at;
+            skip();
+            return *this;
+        }
+        bool operator!=(const iterator &other) const { return at != other.at; }
+    };
+    iterator begin() const { return iterator(&slots, 0); }
+    iterator end() const { return iterator(&slots, slots.size()); }
+};
+
+// Rwanda's administrative levels, from the top down
+const char *const ADMIN_LEVELS[] = {"province", "district", "sector", "cell", "village"};
+const int ADMIN_DEPTH = 5;
+
+// The administrative map: provinces hold districts, districts hold sectors, and so
+// on down to villages. A unit is written as a path, like "Southern/Huye/Ngoma".
+// Units are only ever added; cities point at the deepest one they belong to.
+class AdminTree {
+private:
+    struct Unit {
+        string name;
+        int level; // 0 = province ... 4 = village
+        int parent; // -1 for provinces
+    };
+    vector<Unit> units;
+    map<pair<int, string>, int> children; // (parent, name) -> unit, like a folder listing
+
+    // Split "Southern/Huye/Ngoma" into its parts; empty if a part is blank or it's too deep
+    static vector<string> split(const string &path) {
+        vector<string> parts;
+        string part;
+        istringstream in(path);
+        while (getline(in, part, '/')) {
+            part = trim(part);
+            if (part.empty()) return {};
+            parts.push_back(part);
+        }
+        if (parts.size() > static_cast<size_t>(ADMIN_DEPTH)) return {};
+        return parts;
+    }
+
+public:
+    // The unit for path, making any missing units on the way; -1 if the path is bad
+    int place(const string &path) {
+        vector<string> parts = split(path);
+        if (parts.empty()) return -1;
+        int unit = -1;
+        for (size_t level = 0; level < parts.size(); ++level) {
+            auto [it, added] = children.try_emplace({unit, parts[level]}, static_cast<int>(units.size()));
+            if (added) units.push_back({parts[level], static_cast<int>(level), unit});
+            unit = it->second;
+        }
+        return unit;
+    }
+
+    // The unit for path if it exists, -1 if not
+    int find(const string &path) const {
+        int unit = -1;
+        for (const string &part : split(path)) {
+            auto it = children.find({unit, part});
+            if (it == children.end()) return -1;
+            unit = it->second;
+        }
+        return unit;
+    }
+
+    // "Southern/Huye/Ngoma" for a unit, "" for -1
+    string pathOf(int unit) const {
+        string path;
+        for (; unit != -1; unit = units[unit].parent) path = units[unit].name + (path.empty() ? "" : "/" + path);
+        return path;
+    }
+
+    int levelOf(int unit) const { return units[unit].level; }
+
+    // The unit's ancestor at the given level (itself if it's at that level),
+    // -1 if the unit sits higher up than that
+    int ancestorAt(int unit, int level) const {
+        if (unit == -1 || units[unit].level < level) return -1;
+        while (units[unit].level > level) unit = units[unit].parent;
+        return unit;
+    }
+
+    bool isInside(int unit, int outer) const { return unit != -1 && ancestorAt(unit, units[outer].level) == outer; }
+
+    size_t size() const { return units.size(); }
+
+    // "district" or "2" (levels count from 1 for people) -> 0..4, -1 if unknown
+    static int parseLevel(const string &text) {
+        string word = trim(text);
+        for (int level = 0; level < ADMIN_DEPTH; ++level) {
+            if (word == ADMIN_LEVELS[level] || word == to_string(level + 1)) return level;
+        }
+        return -1;
+    }
+};
+
+// Road money for one administrative unit. A road with both ends in the unit counts
+// as inside; a road crossing its border counts for the units on both sides.
+struct AreaTotal {
+    int unit; // -1 collects the cities that aren't placed anywhere (at this level)
+    size_t cities = 0;
+    size_t roads = 0; // Roads touching the unit, inside or crossing out
+    double inside = 0.0; // Budget of roads with both ends in the unit
+    double border = 0.0; // Budget of roads crossing out of it
+};
+
+const double EARTH_RADIUS_KM = 6371.0;
+const double PI = acos(-1.0); // M_PI is not standard C++, MinGW leaves it out
+const double DEGREES = PI / 180.0; // Multiply degrees by this to get radians
+
+// Is this a real spot on the globe? Latitude -90..90, longitude -180..180
+inline bool validPosition(double latitude, double longitude) {
+    return latitude >= -90.0 && latitude <= 90.0 && longitude >= -180.0 && longitude <= 180.0;
+}
+
+// Kilometers between two map positions as the crow flies (haversine formula)
+inline double distanceKm(double lat1, double lon1, double lat2, double lon2) {
+    double dLat = (lat2 - lat1) * DEGREES, dLon = (lon2 - lon1) * DEGREES;
+    double h = sin(dLat / 2) * sin(dLat / 2) + cos(lat1 * DEGREES) * cos(lat2 * DEGREES) * sin(dLon / 2) * sin(dLon / 2);
+    return 2.0 * EARTH_RADIUS_KM * asin(min(1.0, sqrt(h)));
+}
+
+// A map position as a point on a ball of radius 1 (x, y, z). The straight line between
+// two such points (through the Earth) gets longer exactly when the trip over the
+// surface does, and it's never longer than that trip, so plain x/y/z math works for
+// distances without longitudes squeezing together or wrapping around at 180 degrees.
+inline array<double, 3> toBall(double latitude, double longitude) {
+    double lat = latitude * DEGREES, lon = longitude * DEGREES;
+    return {cos(lat) * cos(lon), cos(lat) * sin(lon), sin(lat)};
+}
+
+// Length of the straight line between two points on the unit ball
+inline double chordBetween(const array<double, 3> &p, const array<double, 3> &q) {
+    double dx = p[0] - q[0], dy = p[1] - q[1], dz = p[2] - q[2];
+    return sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+// A k-d tree of city positions, for "which cities are closest to here?" and "which
+// are within 20 km?" in logarithmic time instead of checking every city. Each node
+// splits its cities in half along x, y or z (whichever they're most spread out on),
+// and a search skips any half that can't hold anything closer than what it has.
+class CityLocator {
+private:
+    struct Point {
+        array<double, 3> at; // Position on the unit ball
+        int city;
+        int axis; // Which coordinate this node splits on
+    };
+    vector<Point> points; // A balanced tree laid out flat: the middle of each range is its node
+
+    // Put the middle city of points[from, to) in the middle, smaller ones left, bigger right
+    void build(size_t from, size_t to) {
+        if (to - from <= 1) return;
+        double low[3] = {2, 2, 2}, high[3] = {-2, -2, -2};
+        for (size_t i = from; i < to; ++i) {
+            for (int d = 0; d < 3; ++d) {
+                low[d] = min(low[d], points[i].at[d]);
+                high[d] = max(high[d], points[i].at[d]);
+            }
+        }
+        int axis = 0;
+        for (int d = 1; d < 3; ++d) {
+            if (high[d] - low[d] > high[axis] - low[axis]) axis = d;
+        }
+        size_t middle = from + (to - from) / 2;
+        nth_element(points.begin() + from, points.begin() + middle, points.begin() + to,
+                    [axis](const Point &p, const Point &q) { return p.at[axis] < q.at[axis]; });
+        points[middle].axis = axis;
+        build(from, middle);
+        build(middle + 1, to);
+    }
+
+    // Keep the k closest cities seen so far in best (farthest on top), by squared chord
+    void searchNearest(size_t from, size_t to, const array<double, 3> &target, size_t k,
+                       priority_queue<pair<double, int>> &best) const {
+        if (from >= to) return;
+        size_t middle = from + (to - from) / 2;
+        const Point &node = points[middle];
+        double d = chordBetween(node.at, target);
+        if (best.size() < k) {
+            best.push({d * d, node.city});
+        } else if (d * d < best.top().first) {
+            best.pop();
+            best.push({d * d, node.city});
+        }
+        double gap = target[node.axis] - node.at[node.axis]; // How far we are from the split
+        bool leftFirst = gap < 0;
+        if (leftFirst) searchNearest(from, middle, target, k, best);
+        else searchNearest(middle + 1, to, target, k, best);
+        if (best.size() < k || gap * gap < best.top().first) { // The other half could still hold a closer one
+            if (leftFirst) searchNearest(middle + 1, to, target, k, best);
+            else searchNearest(from, middle, target, k, best);
+        }
+    }
+
+    void searchWithin(size_t from, size_t to, const array<double, 3> &target, double reach,
+                      vector<pair<double, int>> &found) const {
+        if (from >= to) return;
+        size_t middle = from + (to - from) / 2;
+        const Point &node = points[middle];
+        double d = chordBetween(node.at, target);
+        if (d <= reach) found.push_back({d, node.city});
+        double gap = target[node.axis] - node.at[node.axis];
+        if (gap <= reach) searchWithin(from, middle, target, reach, found);
+        if (-gap <= reach) searchWithin(middle + 1, to, target, reach, found);
+    }
+
+    // Straight line through the Earth -> km over its surface
+    static double chordToKm(double chord) { return 2.0 * EARTH_RADIUS_KM * asin(min(1.0, chord / 2.0)); }
+
+public:
+    // Start over with every city that has a position. O(n log n).
+    void build(const CityTable &cities) {
+        points.clear();
+        for (const City &city : cities) {
+            if (city.located()) points.push_back({toBall(city.latitude, city.longitude), city.index, 0});
+        }
+        build(0, points.size());
+    }
+
+    size_t size() const { return points.size(); }
+    size_t memoryBytes() const { return points.capacity() * sizeof(Point); }
+
+    // The k cities closest to a position, closest first, as (km, city ID)
+    vector<pair<double, int>> nearest(double latitude, double longitude, size_t k) const {
+        priority_queue<pair<double, int>> best;
+        if (k > 0) searchNearest(0, points.size(), toBall(latitude, longitude), k, best);
+        vector<pair<double, int>> found(best.size());
+        for (size_t i = found.size(); i-- > 0; best.pop()) found[i] = {chordToKm(sqrt(best.top().first)), best.top().second};
+        return found;
+    }
+
+    // Every city within km of a position, closest first, as (km, city ID)
+    vector<pair<double, int>> within(double latitude, double longitude, double km) const {
+        double reach = 2.0 * sin(min(km / EARTH_RADIUS_KM, PI) / 2.0); // The same distance as a straight line
+        vector<pair<double, int>> found;
+        searchWithin(0, points.size(), toBall(latitude, longitude), reach, found);
+        for (auto &hit : found) hit.first = chordToKm(hit.first);
+        sort(found.begin(), found.end());
+        return found;
+    }
+};
+
+// One end of a road, kept right next to its budget in the city's neighbor list
+struct Road {
+    int to; // The city on the other end of the road
+    double budget; // Budget in billions of RWF, 0 until someone sets one
+};
+
+// A packed, read-only copy of all roads (CSR layout), great for big queries
+// Roads of city i live in targets/budgets[offsets[i] .. offsets[i + 1])
+struct RoadSnapshot {
+    vector<int> offsets; // Where each city's roads start, one extra slot at the end
+    vector<int> targets; // The neighbor on the other end of each road
+    vector<double> budgets; // The budget of each road, lined up with targets
+};
+
+// Sparse road storage: each city only remembers the roads it really has,
+// so memory grows with the number of roads instead of cities squared
+class RoadNetwork {
+private:
+    vector<vector<Road>> adjacency; // adjacency[i] = every road touching city i
+    size_t roadCount = 0; // How many two-way roads we have
+    mutable RoadSnapshot packed; // Cached CSR copy for read-heavy stuff
+    mutable bool packedDirty = true; // Does the CSR copy need a rebuild?
+
+    // Find the road from a to b in a's list, O(degree of a)
+    const Road *find(int a, int b) const {
+        if (a < 0 || a >= size()) return nullptr;
+        for (const Road &road : adjacency[a]) {
+            if (road.to == b) return &road;
+        }
+        return nullptr;
+    }
+
+    Road *find(int a, int b) {
+        return const_cast<Road *>(static_cast<const RoadNetwork *>(this)->find(a, b));
+    }
+
+public:
+    // Make room for city IDs 0 .. n-1 (only grows, like the old grids)
+    void resize(int n) {
+        if (n > size()) {
+            adjacency.resize(n);
+            packedDirty = true;
+        }
+    }
+
+    int size() const { return static_cast<int>(adjacency.size()); }
+
+    size_t roadTotal() const { return roadCount; }
+
+    bool hasRoad(int a, int b) const { return find(a, b) != nullptr; }
+
+    // Budget of the road between a and b, 0 if there is no road
+    double budget(int a, int b) const {
+        const Road *road = find(a, b);
+        return road ? road->budget : 0.0;
+    }
+
+    // Add a two-way road, false if it is already there
+    bool addRoad(int a, int b, double budget = 0.0) {
+        if (a < 0 || b < 0 || a >= size() || b >= size() || hasRoad(a, b)) return false;
+        adjacency[a].push_back({b, budget});
+        adjacency[b].push_back({a, budget});
+        roadCount++;
+        packedDirty = true;
+        return true;
+    }
+
+    // Set the budget on both directions of an existing road
+    bool setBudget(int a, int b, double budget) {
+        Road *forward = find(a, b);
+        Road *backward = find(b, a);
+        if (!forward || !backward) return false;
+        forward->budget = backward->budget = budget;
+        packedDirty = true;
+        return true;
+    }
+
+    // Take out the road between a and b (both directions), false if there is none
+    bool removeRoad(int a, int b) {
+        if (!hasRoad(a, b)) return false;
+        for (auto [from, to] : {make_pair(a, b), make_pair(b, a)}) {
+            vector<Road> &roads = adjacency[from];
+            for (size_t r = 0; r < roads.size(); ++r) {
+                if (roads[r].to == to) {
+                    roads[r] = roads.back(); // Order doesn't matter, so swap with the last one
+                    roads.pop_back();
+                    break;
+                }
+            }
+        }
+        roadCount--;
+        packedDirty = true;
+        return true;
+    }
+
+    // Renumber every city in one pass: newId[old] is its new ID, or -1 to drop it
+    // (roads to dropped cities go too). The storage shrinks to newSize cities.
+    void renumber(const vector<int> &newId, int newSize) {
+        vector<vector<Road>> moved(newSize);
+        roadCount = 0;
+        for (int i = 0; i < size(); ++i) {
+            if (i >= static_cast<int>(newId.size()) || newId[i] == -1) continue;
+            vector<Road> &roads = moved[newId[i]];
+            roads.reserve(adjacency[i].size());
+            for (const Road &road : adjacency[i]) {
+                int to = road.to < static_cast<int>(newId.size()) ? newId[road.to] : -1;
+                if (to == -1) continue;
+                roads.push_back({to, road.budget});
+                if (to > newId[i]) roadCount++;
+            }
+        }
+        adjacency = move(moved);
+        packedDirty = true;
+    }
+
+    // All roads touching city i
+    const vector<Road> &neighbors(int i) const { return adjacency[i]; }
+
+    // Bytes held by the road lists (and the CSR copy), budgets included
+    size_t memoryBytes() const {
+        size_t bytes = adjacency.capacity() * sizeof(vector<Road>);
+        for (const auto &roads : adjacency) bytes += roads.capacity() * sizeof(Road);
+        bytes += packed.offsets.capacity() * sizeof(int) + packed.targets.capacity() * sizeof(int);
+        return bytes + packed.budgets.capacity() * sizeof(double);
+    }
+
+    // Just the part of that spent on budget numbers
+    size_t budgetBytes() const {
+        return roadCount * 2 * sizeof(double) + packed.budgets.capacity() * sizeof(double);
+    }
+
+    // Build (or reuse) the packed CSR copy of the network
+    const RoadSnapshot &snapshot() const {
+        if (packedDirty) {
+            packed.offsets.assign(adjacency.size() + 1, 0);
+            packed.targets.clear();
+            packed.budgets.clear();
+            packed.targets.reserve(roadCount * 2);
+            packed.budgets.reserve(roadCount * 2);
+            for (size_t i = 0; i < adjacency.size(); ++i) {
+                packed.offsets[i] = static_cast<int>(packed.targets.size());
+                for (const Road &road : adjacency[i]) {
+                    packed.targets.push_back(road.to);
+                    packed.budgets.push_back(road.budget);
+                }
+            }
+            packed.offsets[adjacency.size()] = static_cast<int>(packed.targets.size());
+            packedDirty = false;
+        }
+        return packed;
+    }
+};
+
+// Every road's budget in flat arrays (one slot per road), plus running totals per
+// city and for the whole country. Kept up to date edit by edit, so reports don't have
+// to walk the road lists, and scans run straight down one array of doubles.
+class BudgetLedger {
+private:
+    vector<int> ends[2]; // ends[0][slot], ends[1][slot]: the road's cities, smaller ID first
+    vector<double> amount; // amount[slot]: the road's budget
+    unordered_map<uint64_t, int> slotOf; // (smaller ID, bigger ID) -> slot
+    vector<double> cityTotal; // Sum of the budgets of every road touching each city
+    double national = 0.0;
+
+    // Cached top roads, dropped when a change could reorder them
+    vector<int> top; // Slots, most expensive first
+    size_t topAsked = 0; // How many were asked for when top was worked out
+    bool topValid = false;
+
+    static uint64_t key(int a, int b) {
+        if (a > b) swap(a, b);
+        return (static_cast<uint64_t>(static_cast<uint32_t>(a)) << 32) | static_cast<uint32_t>(b);
+    }
+
+    void addToCities(int slot, double delta) {
+        cityTotal[ends[0][slot]] += delta;
+        cityTotal[ends[1][slot]] += delta;
+        national += delta;
+    }
+
+    bool inTop(int slot) const { return topValid && find(top.begin(), top.end(), slot) != top.end(); }
+
+public:
+    size_t roads() const { return amount.size(); }
+    double total() const { return national; }
+    double cityBudget(int city) const { return city < static_cast<int>(cityTotal.size()) ? cityTotal[city] : 0.0; }
+    pair<int, int> road(int slot) const { return {ends[0][slot], ends[1][slot]}; }
+    double budget(int slot) const { return amount[slot]; }
+
+    void resize(int cityCount) {
+        if (cityCount > static_cast<int>(cityTotal.size())) cityTotal.resize(cityCount, 0.0);
+    }
+
+    // Start over from the road lists (after loading or renumbering)
+    void rebuild(const RoadNetwork &network) {
+        for (auto &list : ends) list.clear();
+        amount.clear();
+        slotOf.clear();
+        slotOf.reserve(network.roadTotal());
+        cityTotal.assign(network.size(), 0.0);
+        national = 0.0;
+        topValid = false;
+        for (int a = 0; a < network.size(); ++a) {
+            for (const Road &road : network.neighbors(a)) {
+                if (road.to > a) roadAdded(a, road.to, road.budget);
+            }
+        }
+    }
+
+    void roadAdded(int a, int b, double budget) {
+        resize(max(a, b) + 1);
+        int slot = static_cast<int>(amount.size());
+        ends[0].push_back(min(a, b));
+        ends[1].push_back(max(a, b));
+        amount.push_back(budget);
+        slotOf[key(a, b)] = slot;
+        addToCities(slot, budget);
+        if (topValid && (top.size() < topAsked || (!top.empty() && budget > amount[top.back()]))) topValid = false;
+    }
+
+    void budgetChanged(int a, int b, double budget) {
+        auto it = slotOf.find(key(a, b));
+        if (it == slotOf.end()) return;
+        int slot = it->second;
+        // Only matters to the top list if the road is in it or now beats its last one
+        if (inTop(slot) || (topValid && !top.empty() && budget > amount[top.back()])) topValid = false;
+        addToCities(slot, budget - amount[slot]);
+        amount[slot] = budget;
+    }
+
+    void roadRemoved(int a, int b) {
+        auto it = slotOf.find(key(a, b));
+        if (it == slotOf.end()) return;
+        int slot = it->second, last = static_cast<int>(amount.size()) - 1;
+        slotOf.erase(it);
+        if (inTop(slot)) topValid = false;
+        addToCities(slot, -amount[slot]);
+        // Move the last road into the hole so the arrays stay packed
+        if (slot != last) {
+            for (auto &list : ends) list[slot] = list[last];
+            amount[slot] = amount[last];
+            slotOf[key(ends[0][slot], ends[1][slot])] = slot;
+            if (topValid) replace(top.begin(), top.end(), last, slot);
+        }
+        for (auto &list : ends) list.pop_back();
+        amount.pop_back();
+    }
+
+    // The k most expensive roads (slots, priciest first). Reuses the last answer
+    // unless an edit could have changed it; otherwise one pass with a small heap.
+    const vector<int> &topRoads(size_t k) {
+        if (topValid && topAsked == k) return top;
+        priority_queue<pair<double, int>, vector<pair<double, int>>, greater<pair<double, int>>> cheapestKept;
+        for (int slot = 0; slot < static_cast<int>(amount.size()); ++slot) {
+            if (cheapestKept.size() < k) {
+                cheapestKept.push({amount[slot], slot});
+            } else if (k > 0 && amount[slot] > cheapestKept.top().first) {
+                cheapestKept.pop();
+                cheapestKept.push({amount[slot], slot});
+            }
+        }
+        top.clear();
+        for (; !cheapestKept.empty(); cheapestKept.pop()) top.push_back(cheapestKept.top().second);
+        reverse(top.begin(), top.end());
+        topAsked = k;
+        topValid = true;
+        return top;
+    }
+
+    // The k cities with the most money on their roads, biggest first
+    vector<int> topCities(size_t k) const {
+        vector<int> order;
+        for (int city = 0; city < static_cast<int>(cityTotal.size()); ++city) {
+            if (cityTotal[city] > 0.0) order.push_back(city);
+        }
+        size_t keep = min(k, order.size());
+        partial_sort(order.begin(), order.begin() + keep, order.end(),
+                     [&](int x, int y) { return cityTotal[x] != cityTotal[y] ? cityTotal[x] > cityTotal[y] : x < y; });
+        order.resize(keep);
+        return order;
+    }
+
+    // How many roads have a budget in [low, high], and their total. Four running
+    // sums and no branches, so the compiler can check several budgets per instruction.
+    pair<size_t, double> countInRange(double low, double high) const {
+        const double *values = amount.data();
+        size_t n = amount.size(), i = 0;
+        double counts[4] = {0.0, 0.0, 0.0, 0.0}, sums[4] = {0.0, 0.0, 0.0, 0.0};
+        for (; i + 4 <= n; i += 4) {
+            for (int lane = 0; lane < 4; ++lane) {
+                double value = values[i + lane];
+                double hit = static_cast<double>((value >= low) & (value <= high));
+                counts[lane] += hit;
+                sums[lane] += hit * value;
+            }
+        }
+        for (; i < n; ++i) { // The last few
+            double hit = static_cast<double>((values[i] >= low) & (values[i] <= high));
+            counts[0] += hit;
+            sums[0] += hit * values[i];
+        }
+        return {static_cast<size_t>(counts[0] + counts[1] + counts[2] + counts[3]), sums[0] + sums[1] + sums[2] + sums[3]};
+    }
+
+    // Slots of the roads with a budget in [low, high], at most limit of them
+    vector<int> roadsInRange(double low, double high, size_t limit) const {
+        vector<int> found;
+        for (int slot = 0; slot < static_cast<int>(amount.size()) && found.size() < limit; ++slot) {
+            if (amount[slot] >= low && amount[slot] <= high) found.push_back(slot);
+        }
+        return found;
+    }
+
+    size_t memoryBytes() const {
+        return (ends[0].capacity() + ends[1].capacity()) * sizeof(int) + amount.capacity() * sizeof(double) +
+               slotOf.bucket_count() * sizeof(void *) + slotOf.size() * (sizeof(pair<uint64_t, int>) + sizeof(void *)) +
+               cityTotal.capacity() * sizeof(double) + top.capacity() * sizeof(int);
+    }
+};
+
+// The operations we keep timing stats for
+enum class Op {
+    AddCity, AddRoad, SetBudget, EditCity, Search, Save, Load, Display, Route, Connectivity, Plan, Resize, Journal,
+    Delete, Compact, Hierarchy, Nearby, SaveWrite,
+    Count // Not an operation, just how many there are
+};
+
+const char *const OP_NAMES[] = {"add_city", "add_road", "set_budget", "edit_city", "search", "save", "load",
+                                "display", "route", "connectivity", "plan", "resize", "journal",
+                                "delete", "compact", "hierarchy", "nearby", "save_write"};
+
+// Count and latency histogram for one operation. Buckets go 8 per power of two
+// (about 9% wide), so p50/p99 are close without storing every timing.
+// Counters are atomic so readers on other threads can record too.
+class LatencyStats {
+private:
+    static const int BUCKETS = 8 * 62;
+    array<atomic<uint64_t>, BUCKETS> buckets{};
+    atomic<uint64_t> count{0}, totalNs{0}, maxNs{0};
+
+    static int bucketOf(uint64_t ns) {
+        if (ns < 8) return static_cast<int>(ns);
+#if defined(__GNUC__) || defined(__clang__)
+        int top = 63 - __builtin_clzll(ns); // Position of the highest set bit
+#else
+        int top = 0;
+        while ((ns >> top) > 1) top++;
+#endif
+        return min(BUCKETS - 1, (top - 2) * 8 + static_cast<int>((ns >> (top - 3)) & 7));
+    }
+
+    // Smallest time that lands in bucket b
+    static uint64_t bucketStart(int b) {
+        if (b < 8) return static_cast<uint64_t>(b);
+        int top = b / 8 + 2;
+        return (8ull + static_cast<uint64_t>(b % 8)) << (top - 3);
+    }
+
+public:
+    void record(uint64_t ns) {
+        buckets[bucketOf(ns)].fetch_add(1, memory_order_relaxed);
+        count.fetch_add(1, memory_order_relaxed);
+        totalNs.fetch_add(ns, memory_order_relaxed);
+        uint64_t seen = maxNs.load(memory_order_relaxed);
+        while (ns > seen && !maxNs.compare_exchange_weak(seen, ns, memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t calls() const { return count.load(memory_order_relaxed); }
+    uint64_t total() const { return totalNs.load(memory_order_relaxed); }
+    uint64_t slowest() const { return maxNs.load(memory_order_relaxed); }
+
+    // Roughly the time that fraction p (like 0.99) of calls finished within
+    uint64_t percentile(double p) const {
+        uint64_t n = calls();
+        if (n == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(p * (n - 1)) + 1, seen = 0;
+        for (int b = 0; b < BUCKETS; ++b) {
+            seen += buckets[b].load(memory_order_relaxed);
+            if (seen >= rank) return min(slowest(), (bucketStart(b) + bucketStart(b + 1)) / 2);
+        }
+        return slowest();
+    }
+};
+
+// Times a block of code and files it under an operation when the block ends:
+//   { OpTimer timer(metrics, Op::Save); ...save stuff... }
+class OpTimer {
+private:
+    LatencyStats &stats;
+    chrono::steady_clock::time_point start;
+
+public:
+    OpTimer(array<LatencyStats, static_cast<size_t>(Op::Count)> &all, Op op)
+        : stats(all[static_cast<size_t>(op)]), start(chrono::steady_clock::now()) {}
+
+    ~OpTimer() {
+        auto ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+        stats.record(static_cast<uint64_t>(ns));
+    }
+};
+
+using OpMetrics = array<LatencyStats, static_cast<size_t>(Op::Count)>;
+
+// A tiny fingerprint of some text (FNV-1a), used to spot half-written journal lines
+inline uint32_t checksum(const string &text) {
+    uint32_t hash = 2166136261u;
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// A wider fingerprint (64-bit FNV-1a) for big binary blobs like the snapshot
+inline uint64_t checksum64(const char *data, size_t size) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Split a line on commas, like "R,1,3" -> {"R", "1", "3"}
+inline vector<string> splitFields(const string &line) {
+    vector<string> fields;
+    stringstream ss(line);
+    string field;
+    while (getline(ss, field, ',')) fields.push_back(field);
+    return fields;
+}
+
+// Make the OS push a file (or a folder's list of files) all the way to the disk instead
+// of keeping it in its cache, so a power cut can't lose it. False if that failed.
+inline bool syncToDisk(const string &path) {
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    bool synced = fsync(fd) == 0;
+    close(fd);
+    return synced;
+#else
+    (void)path; // Windows flushes on close well enough for us
+    return true;
+#endif
+}
+
+// Write a file next to the real one, push it to disk, then swap it in, so a crash
+// never leaves half a file: readers see either the old one or the whole new one
+template <typename Writer>
+bool replaceFile(const string &path, Writer write, ios::openmode mode = ios::out) {
+    string tempPath = path + ".tmp";
+    {
+        ofstream out(tempPath, mode | ios::trunc);
+        if (!out) return false;
+        write(out);
+        out.flush();
+        if (!out) return false;
+    }
+    if (!syncToDisk(tempPath)) return false; // The bytes first, or the rename could land before them
+    error_code ec;
+    filesystem::rename(tempPath, path, ec); // Replaces the old file in one step
+    if (ec) return false;
+    string folder = filesystem::path(path).parent_path().string();
+    syncToDisk(folder.empty() ? "." : folder); // And the rename itself
+    return true;
+}
+
+// A whole file mapped into memory (read-only), so we can use its bytes in place.
+// On Windows we simply read it into a buffer instead.
+class MappedFile {
+private:
+    const char *bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    vector<char> buffer;
+#endif
+
+public:
+    explicit MappedFile(const string &path) {
+#ifdef _WIN32
+        ifstream in(path, ios::binary | ios::ate);
+        if (!in) return;
+        buffer.resize(static_cast<size_t>(in.tellg()));
+        in.seekg(0);
+        if (!in.read(buffer.data(), static_cast<streamsize>(buffer.size()))) return;
+        bytes = buffer.data();
+        length = buffer.size();
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void *mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                bytes = static_cast<const char *>(mapped);
+                length = static_cast<size_t>(info.st_size);
+            }
+        }
+        close(fd); // The mapping stays valid after closing
+#endif
+    }
+
+    ~MappedFile() {
+#ifndef _WIN32
+        if (bytes) munmap(const_cast<char *>(bytes), length);
+#endif
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const char *data() const { return bytes; }
+    size_t size() const { return length; }
+};
+
+// Binary snapshot layout (network.bin), all numbers in this machine's byte order:
+//   SnapshotHeader | SnapshotCity x cityCount | name bytes (string pool) | padding to 8 | SnapshotRoad x roadCount
+// The checksum covers everything after the header.
+const char SNAPSHOT_MAGIC[8] = {'R', 'W', 'R', 'O', 'A', 'D', 'S', '\0'};
+const uint32_t SNAPSHOT_VERSION = 4; // 2: cities carry their area path, 3: and their position, 4: and the checkpoint number
+
+struct SnapshotHeader {
+    char magic[8]; // Always SNAPSHOT_MAGIC
+    uint32_t version; // Bumped whenever the layout changes
+    uint32_t headerSize; // sizeof(SnapshotHeader) when written
+    uint64_t cityCount;
+    uint64_t stringBytes; // Size of the name pool
+    uint64_t roadCount;
+    int64_t nextIndex; // Next city ID to hand out
+    uint64_t checkpoint; // Which checkpoint this is; the journal replays what came after it
+    uint64_t checksum; // checksum64 of everything after the header
+};
+
+struct SnapshotCity {
+    int32_t index; // City ID
+    uint32_t nameLength; // Bytes of the name in the pool
+    uint64_t nameOffset; // Where the name starts in the pool
+    uint32_t areaLength; // Bytes of the area path, right after the name in the pool
+    uint32_t unused; // Keeps the size a multiple of 8
+    double latitude, longitude; // NAN if the city has no position
+};
+
+struct SnapshotRoad {
+    int32_t a, b; // The two cities, a < b
+    double budget; // Billions of RWF
+};
+
+// Round up to a multiple of 8 so the road array stays nicely aligned
+inline size_t alignTo8(size_t n) { return (n + 7) & ~static_cast<size_t>(7); }
+
+// Saved text files start with a note line like "# checkpoint 12", above the normal CSV
+// header, so a load can tell files from different saves apart. Lines starting with '#'
+// before the header are skipped when the rows are read.
+const char CHECKPOINT_NOTE[] = "# checkpoint ";
+
+// Which checkpoint a text file (already in memory) says it holds; 0 if it doesn't
+// say, like a file written by hand or by an older version
+inline uint64_t checkpointOf(const char *data, size_t size) {
+    const size_t noteLength = strlen(CHECKPOINT_NOTE);
+    if (!data || size < noteLength || memcmp(data, CHECKPOINT_NOTE, noteLength) != 0) return 0;
+    uint64_t number = 0;
+    from_chars(data + noteLength, data + size, number);
+    return number;
+}
+
+// Rows parsed out of a text file, plus the lines we couldn't make sense of
+template <typename Row>
+struct ParsedRows {
+    vector<Row> rows; // In file order
+    vector<pair<size_t, string>> bad; // Line number -> the line itself
+};
+
+// Parse every line after the header of a file that's already in memory. Big files get
+// cut into chunks at line boundaries, one per CPU core, and parsed at the same time.
+// parseLine(line, row) fills in a row and returns false if the line is malformed.
+template <typename Row, typename ParseLine>
+ParsedRows<Row> parseLines(const char *data, size_t size, ParseLine parseLine) {
+    ParsedRows<Row> result;
+    const char *end = data + size;
+    size_t notes = 0; // "# ..." lines above the header
+    while (data && data < end && *data == '#') {
+        const char *newline = static_cast<const char *>(memchr(data, '\n', end - data));
+        if (!newline) return result;
+        data = newline + 1;
+        ++notes;
+    }
+    const char *header = data ? static_cast<const char *>(memchr(data, '\n', end - data)) : nullptr;
+    if (!header) return result; // Nothing but a header (or nothing at all)
+    const char *body = header + 1;
+
+    const size_t CHUNK_MIN = 1 << 20; // Small files aren't worth the threads
+    size_t workers = max<size_t>(1, min<size_t>(thread::hardware_concurrency(), (end - body) / CHUNK_MIN));
+    vector<const char *> bounds{body};
+    for (size_t t = 1; t < workers; ++t) {
+        const char *cut = body + (end - body) * t / workers;
+        cut = max(cut, bounds.back());
+        const char *newline = static_cast<const char *>(memchr(cut, '\n', end - cut));
+        bounds.push_back(newline ? newline + 1 : end);
+    }
+    bounds.push_back(end);
+
+    vector<ParsedRows<Row>> parts(workers);
+    vector<size_t> lineCounts(workers, 0);
+    auto parseChunk = [&](size_t t) {
+        const char *line = bounds[t];
+        while (line < bounds[t + 1]) {
+            const char *newline = static_cast<const char *>(memchr(line, '\n', bounds[t + 1] - line));
+            const char *lineEnd = newline ? newline : bounds[t + 1];
+            size_t lineNumber = ++lineCounts[t];
+            string_view text(line, lineEnd - line);
+            if (!text.empty() && text.back() == '\r') text.remove_suffix(1); // Windows line endings
+            if (!text.empty()) {
+                Row row;
+                if (parseLine(text, row)) {
+                    parts[t].rows.push_back(row);
+                } else {
+                    parts[t].bad.emplace_back(lineNumber, string(text));
+                }
+            }
+            line = lineEnd + 1;
+        }
+    };
+    vector<thread> threads;
+    for (size_t t = 1; t < workers; ++t) threads.emplace_back(parseChunk, t);
+    parseChunk(0); // This thread takes the first chunk itself
+    for (thread &worker : threads) worker.join();
+
+    // Stitch the chunks back together, turning chunk line numbers into file line numbers
+    size_t linesBefore = 1 + notes; // The header and any notes above it
+    size_t total = 0;
+    for (const auto &part : parts) total += part.rows.size();
+    result.rows.reserve(total);
+    for (size_t t = 0; t < workers; ++t) {
+        result.rows.insert(result.rows.end(), parts[t].rows.begin(), parts[t].rows.end());
+        for (auto &bad : parts[t].bad) result.bad.emplace_back(linesBefore + bad.first, move(bad.second));
+        linesBefore += lineCounts[t];
+    }
+    return result;
+}
+
+// Read a whole number from the front of text; false if there isn't one
+inline bool takeInt(string_view &text, int &value) {
+    auto [next, error] = from_chars(text.data(), text.data() + text.size(), value);
+    if (error != errc()) return false;
+    text.remove_prefix(next - text.data());
+    return true;
+}
+
+// Expect a certain character next, like the '-' in "1-3"
+inline bool takeChar(string_view &text, char c) {
+    if (text.empty() || text.front() != c) return false;
+    text.remove_prefix(1);
+    return true;
+}
+
+// Read a decimal number that fills the whole of text
+inline bool readDouble(string_view text, double &value) {
+    auto [next, error] = from_chars(text.data(), text.data() + text.size(), value);
+    return error == errc() && next == text.data() + text.size();
+}
+
+// One row of cities.txt: "index,city_name[,area[,latitude,longitude]]". The area may
+// be empty when only the position is known. Name and area point into the file's memory.
+struct CityRow {
+    int index;
+    string_view name;
+    string_view area; // Like "Southern/Huye", empty if not placed
+    double latitude = NAN, longitude = NAN;
+};
+
+inline bool parseCityRow(string_view line, CityRow &row) {
+    if (!takeInt(line, row.index) || row.index < 0 || !takeChar(line, ',')) return false;
+    size_t comma = line.find(',');
+    row.name = line.substr(0, comma);
+    row.area = string_view();
+    row.latitude = row.longitude = NAN;
+    if (comma != string_view::npos) {
+        line.remove_prefix(comma + 1);
+        comma = line.find(',');
+        row.area = line.substr(0, comma);
+        if (comma != string_view::npos) {
+            line.remove_prefix(comma + 1);
+            comma = line.find(',');
+            if (comma == string_view::npos || !readDouble(line.substr(0, comma), row.latitude) ||
+                !readDouble(line.substr(comma + 1), row.longitude) || !validPosition(row.latitude, row.longitude)) {
+                return false;
+            }
+        }
+    }
+    return !row.name.empty();
+}
+
+// One row of roads.txt: "city1-city2,budget"
+struct RoadRow {
+    int city1, city2;
+    double budget;
+};
+
+inline bool parseRoadRow(string_view line, RoadRow &row) {
+    if (!takeInt(line, row.city1) || !takeChar(line, '-') || !takeInt(line, row.city2) || !takeChar(line, ',')) {
+        return false;
+    }
+    return readDouble(line, row.budget);
+}
+
+// Builds a whole screen of text in memory, then prints it with a single write.
+// Much faster than pushing every little cell through cout with setw.
+class ScreenBuffer {
+private:
+    string text;
+
+    // Right-align like setw: spaces first, then the value
+    ScreenBuffer &padded(const char *begin, const char *end, int width) {
+        int length = static_cast<int>(end - begin);
+        if (width > length) text.append(width - length, ' ');
+        text.append(begin, end);
+        return *this;
+    }
+
+public:
+    ScreenBuffer &add(string_view part) {
+        text.append(part.data(), part.size());
+        return *this;
+    }
+
+    ScreenBuffer &number(long long value, int width = 0) {
+        char digits[24];
+        auto result = to_chars(digits, digits + sizeof(digits), value);
+        return padded(digits, result.ptr, width);
+    }
+
+    ScreenBuffer &money(double value, int width = 0) { // Always 2 decimals, like fixed << setprecision(2)
+        char digits[64];
+        auto result = to_chars(digits, digits + sizeof(digits), value, chars_format::fixed, 2);
+        return padded(digits, result.ptr, width);
+    }
+
+    // Send everything to the screen in one go and start over
+    void flush() {
+        cout.write(text.data(), static_cast<streamsize>(text.size()));
+        cout.flush();
+        text.clear();
+    }
+};
+
+// Append-only change log: every edit is one small line at the end of journal.txt,
+// like jotting notes in a diary instead of rewriting the whole book each time.
+// Each line ends with a checksum so a line cut short by a crash gets ignored.
+// At a checkpoint the lines are set aside in journal.txt.old, under a "K,<checkpoint
+// number>" line, until the files that hold them are safely on disk; new edits start
+// a fresh journal.txt in the meantime.
+class Journal {
+private:
+    string path; // Where the journal lives
+    string asidePath; // Records waiting for a checkpoint to reach the disk
+    ofstream out; // Opened lazily on the first append
+    size_t records = 0; // Lines written since the last checkpoint
+
+    // Feed every good record in one file to apply(fields); stops at the first damaged line.
+    // The damaged part (like the half line a crash left behind) is cut off the file, or
+    // the next record appended would get glued onto it and be lost too.
+    template <typename Apply>
+    static size_t replayFile(const string &file, Apply apply) {
+        ifstream in(file, ios::binary);
+        if (!in) return 0;
+        string line;
+        size_t applied = 0;
+        int lineNumber = 0;
+        uintmax_t goodBytes = 0; // Where the last good record ends
+        bool damaged = false;
+        while (getline(in, line)) {
+            lineNumber++;
+            bool complete = !in.eof(); // The last line of a crashed write has no newline
+            size_t comma = line.rfind(',');
+            bool valid = complete && comma != string::npos;
+            if (valid) {
+                string body = line.substr(0, comma);
+                try {
+                    valid = stoul(line.substr(comma + 1), nullptr, 16) == checksum(body);
+                } catch (...) {
+                    valid = false;
+                }
+                if (valid) valid = apply(splitFields(body));
+            }
+            if (!valid) {
+                cout << "Warning: " << file << " line " << lineNumber << " is damaged, ignoring the rest of it\n";
+                damaged = true;
+                break;
+            }
+            applied++;
+            goodBytes = static_cast<uintmax_t>(in.tellg());
+        }
+        in.close();
+        if (damaged) {
+            error_code ec;
+            filesystem::resize_file(file, goodBytes, ec);
+        }
+        return applied;
+    }
+
+public:
+    explicit Journal(string journalPath) : path(move(journalPath)), asidePath(path + ".old") {}
+
+    size_t size() const { return records; }
+
+    // Add one record, like "R,1,3", and push it out to the file right away
+    void append(const string &record) {
+        if (!out.is_open()) out.open(path, ios::app);
+        out << record << "," << hex << checksum(record) << dec << "\n";
+        out.flush();
+        records++;
+    }
+
+    // Feed every good record to apply(fields): first the set-aside ones from checkpoints
+    // after `saved` (the last one known to be on disk), then the current journal.
+    // newest gets the highest checkpoint number seen.
+    template <typename Apply>
+    size_t replay(Apply apply, uint64_t saved, uint64_t &newest) {
+        bool covered = false; // Is the checkpoint we're reading about already in the files?
+        size_t aside = replayFile(asidePath, [&](const vector<string> &fields) {
+            if (fields.size() == 2 && fields[0] == "K") {
+                uint64_t number = stoull(fields[1]);
+                newest = max(newest, number);
+                covered = number <= saved;
+                return true;
+            }
+            return covered || apply(fields);
+        });
+        records = replayFile(path, apply);
+        return aside + records;
+    }
+
+    // Checkpoint `number` started: move the records so far to the end of the set-aside
+    // file, under a line saying which checkpoint they belong to, and start an empty journal
+    void setAside(uint64_t number) {
+        if (out.is_open()) out.close();
+        {
+            ifstream in(path, ios::binary);
+            ofstream aside(asidePath, ios::app | ios::binary);
+            string marker = "K," + to_string(number);
+            aside << marker << "," << hex << checksum(marker) << dec << "\n";
+            if (in && in.peek() != ifstream::traits_type::eof()) aside << in.rdbuf();
+        }
+        ofstream(path, ios::trunc);
+        records = 0;
+    }
+
+    // Every set-aside checkpoint is on disk now, so they can all go
+    void dropSetAside() {
+        error_code ec;
+        filesystem::remove(asidePath, ec);
+    }
+};
+
+// A 4-ary min-heap of cities keyed by cost that remembers where each city sits,
+// so a city's cost can be lowered in place instead of pushing duplicates
+class IndexedHeap {
+private:
+    static const int ARITY = 4; // Shallower than a binary heap, friendlier to the cache
+    vector<int> heap; // City IDs, cheapest on top
+    vector<int> position; // City ID -> slot in heap, -1 if not in the heap
+    vector<double> key; // City ID -> its cost in the heap
+
+    void place(int slot, int city) {
+        heap[slot] = city;
+        position[city] = slot;
+    }
+
+    void siftUp(int slot) {
+        int city = heap[slot];
+        while (slot > 0) {
+            int parent = (slot - 1) / ARITY;
+            if (key[heap[parent]] <= key[city]) break;
+            place(slot, heap[parent]);
+            slot = parent;
+        }
+        place(slot, city);
+    }
+
+    void siftDown(int slot) {
+        int city = heap[slot];
+        int count = static_cast<int>(heap.size());
+        while (true) {
+            int first = slot * ARITY + 1;
+            if (first >= count) break;
+            int best = first;
+            for (int child = first + 1; child < first + ARITY && child < count; ++child) {
+                if (key[heap[child]] < key[heap[best]]) best = child;
+            }
+            if (key[heap[best]] >= key[city]) break;
+            place(slot, heap[best]);
+            slot = best;
+        }
+        place(slot, city);
+    }
+
+public:
+    explicit IndexedHeap(int cityCount) : position(cityCount, -1), key(cityCount, 0.0) {}
+
+    bool empty() const { return heap.empty(); }
+
+    // Cost of the cheapest city waiting (don't call when empty)
+    double topKey() const { return key[heap[0]]; }
+
+    // Drop everything still waiting, so the heap can be reused for the next search
+    void clear() {
+        for (int city : heap) position[city] = -1;
+        heap.clear();
+    }
+
+    // Add a city, or lower its cost if it's already waiting
+    void pushOrDecrease(int city, double cost) {
+        key[city] = cost;
+        if (position[city] == -1) {
+            heap.push_back(city);
+            position[city] = static_cast<int>(heap.size()) - 1;
+        }
+        siftUp(position[city]);
+    }
+
+    // Take the cheapest city off the top
+    int pop() {
+        int top = heap[0];
+        position[top] = -1;
+        int last = heap.back();
+        heap.pop_back();
+        if (!heap.empty()) {
+            place(0, last);
+            siftDown(0);
+        }
+        return top;
+    }
+};
+
+// Cheapest costs from one starting city to everyone, plus how we got there
+struct RouteTree {
+    vector<double> cost; // Total budget to reach each city, infinity if unreachable
+    vector<int> parent; // The city we came from, -1 for the start (or unreachable)
+};
+
+// Route finder: road budgets are the edge weights, so "cheapest" means least money.
+// Trees from recent starting cities are cached and patched as roads change, so asking
+// "Kigali to X" again and again doesn't redo the whole search.
+class RouteEngine {
+private:
+    static const size_t MAX_CACHED = 8; // Each tree costs memory per city, keep a few
+    vector<pair<int, RouteTree>> cache; // Starting city -> tree, oldest first
+    RouteTree guided; // Scratch space for A*, reused between searches
+    vector<int> guidedTouched; // Cities A* gave a cost to, so only those get reset
+    vector<IndexedHeap> guidedHeap; // Zero or one heap, sized to the network
+    vector<IndexedHeap> patchHeap; // Same for patching cached trees after a road edit
+    int patchCities = 0; // Cities patchHeap was sized for
+
+    // Dijkstra's main loop: settle cities off the heap and relax their roads.
+    // With stopAt set, quit as soon as that city is settled (its cost is final then).
+    template <typename ForEachRoad>
+    static void settle(RouteTree &tree, IndexedHeap &heap, ForEachRoad forEachRoad, int stopAt = -1) {
+        while (!heap.empty()) {
+            int city = heap.pop();
+            if (city == stopAt) return;
+            double here = tree.cost[city];
+            forEachRoad(city, [&](int next, double budget) {
+                if (here + budget < tree.cost[next]) {
+                    tree.cost[next] = here + budget;
+                    tree.parent[next] = city;
+                    heap.pushOrDecrease(next, tree.cost[next]);
+                }
+            });
+        }
+    }
+
+public:
+    // Full Dijkstra from source over the packed road snapshot; with stopAt it only goes
+    // as far as needed to reach that city (the rest of the tree is left unfinished)
+    static RouteTree cheapestFrom(const RoadSnapshot &roads, int source, int stopAt = -1) {
+        int n = static_cast<int>(roads.offsets.size()) - 1;
+        RouteTree tree{vector<double>(n, numeric_limits<double>::infinity()), vector<int>(n, -1)};
+        IndexedHeap heap(n);
+        tree.cost[source] = 0.0;
+        heap.pushOrDecrease(source, 0.0);
+        settle(tree, heap, [&](int city, auto relax) {
+            for (int r = roads.offsets[city]; r < roads.offsets[city + 1]; ++r) relax(roads.targets[r], roads.budgets[r]);
+        }, stopAt);
+        return tree;
+    }
+
+    // A* from `from` to `to`: Dijkstra where a city waits in the heap with its cost so
+    // far plus guess(city), a lower bound on the money still needed to reach `to`. Good
+    // guesses pull the search straight towards the target instead of in every direction.
+    // The guess must never overestimate, and must never drop by more than a road costs
+    // along that road, or the route found may not be the cheapest. Fills path (both ends
+    // included) and returns the cost, or infinity and an empty path if there's no route.
+    template <typename Guess>
+    double guidedRoute(const RoadSnapshot &roads, int from, int to, Guess guess, vector<int> &path) {
+        int n = static_cast<int>(roads.offsets.size()) - 1;
+        if (static_cast<int>(guided.cost.size()) != n) {
+            guided = {vector<double>(n, numeric_limits<double>::infinity()), vector<int>(n, -1)};
+            guidedTouched.clear();
+            guidedHeap.clear();
+            guidedHeap.emplace_back(n);
+        }
+        for (int city : guidedTouched) guided.cost[city] = numeric_limits<double>::infinity();
+        guidedTouched.clear();
+        IndexedHeap &heap = guidedHeap[0];
+        heap.clear();
+        guided.cost[from] = 0.0;
+        guided.parent[from] = -1;
+        guidedTouched.push_back(from);
+        heap.pushOrDecrease(from, guess(from));
+        path.clear();
+        while (!heap.empty()) {
+            int city = heap.pop();
+            if (city == to) {
+                path = pathTo(guided, to);
+                return guided.cost[to];
+            }
+            double here = guided.cost[city];
+            for (int r = roads.offsets[city]; r < roads.offsets[city + 1]; ++r) {
+                int next = roads.targets[r];
+                double cost = here + roads.budgets[r];
+                if (cost < guided.cost[next]) {
+                    if (guided.cost[next] == numeric_limits<double>::infinity()) guidedTouched.push_back(next);
+                    guided.cost[next] = cost;
+                    guided.parent[next] = city;
+                    heap.pushOrDecrease(next, cost + guess(next));
+                }
+            }
+        }
+        return numeric_limits<double>::infinity();
+    }
+
+    // Plain BFS: the route that uses the fewest roads, empty if there is none
+    static vector<int> fewestRoads(const RoadSnapshot &roads, int from, int to) {
+        int n = static_cast<int>(roads.offsets.size()) - 1;
+        vector<int> parent(n, -2); // -2 = not seen yet
+        deque<int> queue{from};
+        parent[from] = -1;
+        while (!queue.empty() && parent[to] == -2) {
+            int city = queue.front();
+            queue.pop_front();
+            for (int r = roads.offsets[city]; r < roads.offsets[city + 1]; ++r) {
+                int next = roads.targets[r];
+                if (parent[next] == -2) {
+                    parent[next] = city;
+                    queue.push_back(next);
+                }
+            }
+        }
+        vector<int> path;
+        if (parent[to] == -2) return path;
+        for (int city = to; city != -1; city = parent[city]) path.push_back(city);
+        reverse(path.begin(), path.end());
+        return path;
+    }
+
+    // Walk the tree back from target to get the route, empty if unreachable
+    static vector<int> pathTo(const RouteTree &tree, int target) {
+        vector<int> path;
+        if (tree.cost[target] == numeric_limits<double>::infinity()) return path;
+        for (int city = target; city != -1; city = tree.parent[city]) path.push_back(city);
+        reverse(path.begin(), path.end());
+        return path;
+    }
+
+    // Tree for source, from the cache if we have it
+    const RouteTree &treeFrom(const RoadNetwork &network, int source) {
+        for (auto &entry : cache) {
+            if (entry.first == source && static_cast<int>(entry.second.cost.size()) == network.size()) {
+                return entry.second;
+            }
+        }
+        cache.erase(remove_if(cache.begin(), cache.end(), [&](const pair<int, RouteTree> &entry) {
+            return entry.first == source;
+        }), cache.end());
+        if (cache.size() >= MAX_CACHED) cache.erase(cache.begin()); // Forget the oldest
+        cache.emplace_back(source, cheapestFrom(network.snapshot(), source));
+        return cache.back().second;
+    }
+
+    // A road between a and b was added (oldBudget = infinity) or got a new budget.
+    // Cheaper roads are patched into each cached tree by re-relaxing from the road;
+    // a pricier road only matters if the tree used it, and then that tree is dropped.
+    void roadChanged(const RoadNetwork &network, int a, int b, double oldBudget, double newBudget) {
+        for (size_t i = 0; i < cache.size();) {
+            RouteTree &tree = cache[i].second;
+            if (static_cast<int>(tree.cost.size()) != network.size()) { // New cities since, start over
+                cache.erase(cache.begin() + i);
+                continue;
+            }
+            if (newBudget > oldBudget) {
+                if (tree.parent[a] == b || tree.parent[b] == a) {
+                    cache.erase(cache.begin() + i);
+                    continue;
+                }
+            } else {
+                // One heap for every edit: a fresh one per tree would cost a pass over all
+                // cities before any patching. Dijkstra leaves it empty, so nothing to reset.
+                if (patchHeap.empty() || patchCities != network.size()) {
+                    patchHeap.clear();
+                    patchHeap.emplace_back(network.size());
+                    patchCities = network.size();
+                }
+                IndexedHeap &heap = patchHeap[0];
+                for (auto [from, to] : {make_pair(a, b), make_pair(b, a)}) {
+                    if (tree.cost[from] + newBudget < tree.cost[to]) {
+                        tree.cost[to] = tree.cost[from] + newBudget;
+                        tree.parent[to] = from;
+                        heap.pushOrDecrease(to, tree.cost[to]);
+                    }
+                }
+                settle(tree, heap, [&](int city, auto relax) {
+                    for (const Road &road : network.neighbors(city)) relax(road.to, road.budget);
+                });
+            }
+            ++i;
+        }
+    }
+
+    void clear() { cache.clear(); }
+};
+
+// Contraction hierarchy: a preprocessing step that makes cheapest routes between two
+// cities take microseconds. Cities are "contracted" one by one, least important first;
+// when taking a city out would break the cheapest way between two of its neighbors, a
+// shortcut road is added between them that remembers the city it skips. A query then
+// only climbs towards more important cities from both ends until the searches meet,
+// which touches a few hundred cities instead of the whole country.
+class ContractionHierarchy {
+private:
+    struct Arc {
+        int to;
+        double cost;
+        int middle; // The city a shortcut skips over, -1 for a real road
+    };
+    static const int SIMULATE_SETTLE = 30; // Witness search effort while picking the order
+    static const int CONTRACT_SETTLE = 200; // ...and while really contracting
+    static constexpr double REORDER_GROWTH = 0.1; // Past 10% new cities, pick a fresh order
+    static const int SCAN_ALLOWANCE = 600; // Witness search work allowed per road, times the 4th root of the city count
+
+    vector<vector<Arc>> up; // up[v] = roads and shortcuts from v to more important cities
+    vector<int> order; // order[k] = k-th city contracted, kept so rebuilds can reuse it
+    int built = 0; // Cities covered by the last build, 0 = never built
+
+    // Query scratch space, reused so a query only resets the cities it touched
+    vector<double> dist[2];
+    vector<int> parent[2], via[2], touched[2];
+    vector<IndexedHeap> heaps;
+
+    // A small Dijkstra between the neighbors of the city being contracted: is there a
+    // path from source that avoids `skip` and is no pricier than going through it?
+    struct WitnessSearch {
+        vector<double> dist;
+        vector<int> touched;
+        IndexedHeap heap;
+        size_t scanned = 0; // Arcs looked at over every search so far: how hard the build is working
+        explicit WitnessSearch(int n) : dist(n, numeric_limits<double>::infinity()), heap(n) {}
+
+        void run(const vector<vector<Arc>> &graph, const vector<char> &contracted, int source, int skip,
+                 double maxCost, int settleLimit) {
+            for (int city : touched) dist[city] = numeric_limits<double>::infinity();
+            touched.clear();
+            heap.clear();
+            dist[source] = 0.0;
+            touched.push_back(source);
+            heap.pushOrDecrease(source, 0.0);
+            for (int settled = 0; !heap.empty() && settled < settleLimit; ++settled) {
+                if (heap.topKey() > maxCost) break;
+                int city = heap.pop();
+                scanned += graph[city].size();
+                for (const Arc &arc : graph[city]) {
+                    if (arc.to == skip || contracted[arc.to]) continue;
+                    double cost = dist[city] + arc.cost;
+                    if (cost < dist[arc.to]) {
+                        if (dist[arc.to] == numeric_limits<double>::infinity()) touched.push_back(arc.to);
+                        dist[arc.to] = cost;
+                        heap.pushOrDecrease(arc.to, cost);
+                    }
+                }
+            }
+        }
+    };
+
+    // Road or shortcut a-b in the working graph, keeping only the cheaper one
+    static void addArc(vector<vector<Arc>> &graph, int a, int b, double cost, int middle) {
+        for (auto [from, to] : {make_pair(a, b), make_pair(b, a)}) {
+            bool found = false;
+            for (Arc &arc : graph[from]) {
+                if (arc.to == to) {
+                    if (cost < arc.cost) arc = {to, cost, middle};
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) graph[from].push_back({to, cost, middle});
+        }
+    }
+
+    // Take city v out of the working graph. With simulate, just count the shortcuts
+    // it would need; otherwise add them and record v's arcs upward.
+    int contract(vector<vector<Arc>> &graph, vector<char> &contracted, WitnessSearch &witness, int v, bool simulate) {
+        vector<Arc> &around = graph[v];
+        around.erase(remove_if(around.begin(), around.end(), [&](const Arc &arc) { return contracted[arc.to]; }),
+                     around.end());
+        int shortcuts = 0;
+        for (size_t i = 0; i + 1 < around.size(); ++i) {
+            double farthest = 0.0;
+            for (size_t j = i + 1; j < around.size(); ++j) farthest = max(farthest, around[j].cost);
+            witness.run(graph, contracted, around[i].to, v, around[i].cost + farthest,
+                        simulate ? SIMULATE_SETTLE : CONTRACT_SETTLE);
+            for (size_t j = i + 1; j < around.size(); ++j) {
+                double through = around[i].cost + around[j].cost;
+                if (witness.dist[around[j].to] <= through) continue; // Another way is as cheap
+                shortcuts++;
+                if (!simulate) addArc(graph, around[i].to, around[j].to, through, v);
+            }
+        }
+        if (!simulate) {
+            contracted[v] = 1;
+            up[v] = around;
+            for (const Arc &arc : around) { // Neighbors forget v, keeping their lists short
+                vector<Arc> &theirs = graph[arc.to];
+                theirs.erase(remove_if(theirs.begin(), theirs.end(), [&](const Arc &back) { return back.to == v; }),
+                             theirs.end());
+            }
+            vector<Arc>().swap(around);
+        }
+        return shortcuts;
+    }
+
+    // The middle city of the arc from `low` up to `high`
+    int middleOf(int low, int high) const {
+        for (const Arc &arc : up[low]) {
+            if (arc.to == high) return arc.middle;
+        }
+        return -1;
+    }
+
+    // Turn the step from -> to (through `middle` if it's a shortcut) back into real
+    // roads, adding every city after `from` to the path
+    void unpack(int from, int to, int middle, vector<int> &path) const {
+        vector<array<int, 3>> steps{{from, to, middle}};
+        while (!steps.empty()) {
+            auto [a, b, m] = steps.back();
+            steps.pop_back();
+            if (m == -1) {
+                path.push_back(b);
+                continue;
+            }
+            steps.push_back({m, b, middleOf(m, b)}); // Second half, done after...
+            steps.push_back({a, m, middleOf(m, a)}); // ...the first half
+        }
+    }
+
+public:
+    // Cities the hierarchy was built for (0 = not built yet)
+    int size() const { return built; }
+
+    // Shortcuts plus roads, counted once per direction they go up
+    size_t arcCount() const {
+        size_t arcs = 0;
+        for (const auto &list : up) arcs += list.size();
+        return arcs;
+    }
+
+    // (Re)build from the road snapshot. If we built before and not too many cities are
+    // new, the old contraction order is reused (new cities go first), which skips the
+    // slow part: working out how important each city is.
+    // On a flat map the witness search work per road grows only slowly with its size:
+    // grids with random budgets need about 140 x 4th root(cities) per road from 100 to
+    // 22k cities, real-looking maps far less. A tangle of roads crossing everywhere (like
+    // random test data) blows up instead: 2000 such cities needed 120k per road and over
+    // 30 s. Past SCAN_ALLOWANCE x roads x 4th root(cities) we stop, drop the hierarchy
+    // and return false, so the caller can route another way.
+    bool build(const RoadSnapshot &roads) {
+        int n = static_cast<int>(roads.offsets.size()) - 1;
+        vector<vector<Arc>> graph(n);
+        for (int city = 0; city < n; ++city) {
+            for (int r = roads.offsets[city]; r < roads.offsets[city + 1]; ++r) {
+                graph[city].push_back({roads.targets[r], roads.budgets[r], -1});
+            }
+        }
+        up.assign(n, {});
+        vector<char> contracted(n, 0);
+        WitnessSearch witness(n);
+        size_t workLimit = static_cast<size_t>(SCAN_ALLOWANCE * sqrt(sqrt(max(n, 1))) * (roads.targets.size() / 2 + n));
+        auto giveUp = [&] {
+            vector<vector<Arc>>().swap(up);
+            order.clear();
+            built = 0;
+            return false;
+        };
+        if (built > 0 && n - built <= REORDER_GROWTH * built) {
+            vector<int> reused;
+            reused.reserve(n);
+            for (int city = built; city < n; ++city) reused.push_back(city); // New cities first
+            reused.insert(reused.end(), order.begin(), order.end());
+            order.swap(reused);
+            for (int city : order) {
+                contract(graph, contracted, witness, city, false);
+                if (witness.scanned > workLimit) return giveUp();
+            }
+        } else {
+            // Importance = 2 x (shortcuts it needs - roads it removes) + neighbors already
+            // gone. Neighbors are re-scored after each contraction, and a city is checked
+            // once more when it reaches the top in case it got more important since.
+            vector<int> gone(n, 0), score(n);
+            auto importance = [&](int city) {
+                int shortcuts = contract(graph, contracted, witness, city, true);
+                return 2 * (shortcuts - static_cast<int>(graph[city].size())) + gone[city];
+            };
+            priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> queue;
+            for (int city = 0; city < n; ++city) queue.push({score[city] = importance(city), city});
+            order.clear();
+            while (!queue.empty()) {
+                if (witness.scanned > workLimit) return giveUp();
+                auto [oldScore, city] = queue.top();
+                queue.pop();
+                if (contracted[city] || oldScore != score[city]) continue; // Outdated entry
+                score[city] = importance(city);
+                if (!queue.empty() && score[city] > queue.top().first) {
+                    queue.push({score[city], city}); // Got more important since, try again later
+                    continue;
+                }
+                vector<int> neighbors;
+                for (const Arc &arc : graph[city]) neighbors.push_back(arc.to);
+                contract(graph, contracted, witness, city, false);
+                order.push_back(city);
+                for (int next : neighbors) {
+                    gone[next]++;
+                    queue.push({score[next] = importance(next), next});
+                }
+            }
+        }
+        built = n;
+        for (int side = 0; side < 2; ++side) {
+            dist[side].assign(n, numeric_limits<double>::infinity());
+            parent[side].assign(n, -1);
+            via[side].assign(n, -1);
+            touched[side].clear();
+        }
+        heaps.clear();
+        heaps.emplace_back(n);
+        heaps.emplace_back(n);
+        return true;
+    }
+
+    // Cheapest route from `from` to `to`: fills path (both ends included) and returns
+    // its cost, or infinity (and an empty path) if they aren't connected
+    double route(int from, int to, vector<int> &path) {
+        path.clear();
+        for (int side = 0; side < 2; ++side) {
+            for (int city : touched[side]) dist[side][city] = numeric_limits<double>::infinity();
+            touched[side].clear();
+            heaps[side].clear();
+        }
+        int start[2] = {from, to};
+        for (int side = 0; side < 2; ++side) {
+            dist[side][start[side]] = 0.0;
+            parent[side][start[side]] = -1;
+            touched[side].push_back(start[side]);
+            heaps[side].pushOrDecrease(start[side], 0.0);
+        }
+        double best = numeric_limits<double>::infinity();
+        int meet = -1;
+        while (true) {
+            // Search from whichever side has the cheaper city waiting, until neither can beat best
+            bool open[2] = {!heaps[0].empty() && heaps[0].topKey() < best, !heaps[1].empty() && heaps[1].topKey() < best};
+            if (!open[0] && !open[1]) break;
+            int side = !open[0] ? 1 : !open[1] ? 0 : (heaps[0].topKey() <= heaps[1].topKey() ? 0 : 1);
+            int city = heaps[side].pop();
+            double here = dist[side][city];
+            if (here + dist[1 - side][city] < best) {
+                best = here + dist[1 - side][city];
+                meet = city;
+            }
+            for (const Arc &arc : up[city]) {
+                double cost = here + arc.cost;
+                if (cost < dist[side][arc.to]) {
+                    if (dist[side][arc.to] == numeric_limits<double>::infinity()) touched[side].push_back(arc.to);
+                    dist[side][arc.to] = cost;
+                    parent[side][arc.to] = city;
+                    via[side][arc.to] = arc.middle;
+                    heaps[side].pushOrDecrease(arc.to, cost);
+                }
+            }
+        }
+        if (meet == -1) return best;
+        // Climb back down both sides: from..meet, then meet..to, expanding shortcuts
+        vector<int> upward;
+        for (int city = meet; city != -1; city = parent[0][city]) upward.push_back(city);
+        reverse(upward.begin(), upward.end());
+        path.push_back(from);
+        for (size_t i = 1; i < upward.size(); ++i) unpack(upward[i - 1], upward[i], via[0][upward[i]], path);
+        for (int city = meet; parent[1][city] != -1; city = parent[1][city]) {
+            unpack(city, parent[1][city], via[1][city], path);
+        }
+        return best;
+    }
+};
+
+// Union-find (disjoint sets) over city IDs: tells in almost O(1) whether two cities
+// are linked by some chain of roads. Path compression + union by rank keep trees flat.
+class UnionFind {
+private:
+    vector<int> parent; // parent[i] == i means i is the root of its group
+    vector<int> rank; // Rough tree height, so we hang small trees under big ones
+    vector<int> groupSize; // Cities in the group, valid at roots
+    size_t merges = 0; // How many unions actually joined two groups
+
+public:
+    // Grow to n slots; new slots start as groups of one
+    void resize(int n) {
+        for (int i = static_cast<int>(parent.size()); i < n; ++i) {
+            parent.push_back(i);
+            rank.push_back(0);
+            groupSize.push_back(1);
+        }
+    }
+
+    // Forget every union, like tearing down all roads on paper
+    void reset(int n) {
+        parent.clear();
+        rank.clear();
+        groupSize.clear();
+        merges = 0;
+        resize(n);
+    }
+
+    int find(int x) {
+        int root = x;
+        while (parent[root] != root) root = parent[root];
+        while (parent[x] != root) { // Point everyone on the way straight at the root
+            int next = parent[x];
+            parent[x] = root;
+            x = next;
+        }
+        return root;
+    }
+
+    // Join the groups of a and b; false if they were already together
+    bool unite(int a, int b) {
+        a = find(a);
+        b = find(b);
+        if (a == b) return false;
+        if (rank[a] < rank[b]) swap(a, b);
+        parent[b] = a;
+        groupSize[a] += groupSize[b];
+        if (rank[a] == rank[b]) rank[a]++;
+        merges++;
+        return true;
+    }
+
+    bool connected(int a, int b) { return find(a) == find(b); }
+
+    int sizeOf(int x) { return groupSize[find(x)]; }
+
+    size_t mergeCount() const { return merges; }
+};
+
+// One road as a plain record, handy for planning (a < b)
+struct PlannedRoad {
+    int a, b; // The two cities
+    double budget; // Its budget in billions of RWF
+};
+
+// The result of planning: the cheapest set of roads that still connects everything
+// that can be connected (a minimum spanning forest), and the roads we could skip
+struct NetworkPlan {
+    vector<PlannedRoad> kept; // Roads in the minimum spanning forest
+    vector<PlannedRoad> redundant; // Roads that would only close a loop
+    double totalCost = 0.0; // Budget of the kept roads
+};
+
+// Minimum spanning forest planners. Kruskal is simple and fast for normal sizes;
+// Borůvka splits the work over all CPU cores for village-sized networks.
+// Both break budget ties by road position, so they always pick the same roads.
+class NetworkPlanner {
+private:
+    // Road i beats road j if it's cheaper, or equally cheap and earlier in the list
+    static bool cheaper(const vector<PlannedRoad> &roads, int i, int j) {
+        return roads[i].budget < roads[j].budget || (roads[i].budget == roads[j].budget && i < j);
+    }
+
+    static NetworkPlan collect(const vector<PlannedRoad> &roads, const vector<char> &inForest) {
+        NetworkPlan plan;
+        for (size_t i = 0; i < roads.size(); ++i) {
+            if (inForest[i]) {
+                plan.kept.push_back(roads[i]);
+                plan.totalCost += roads[i].budget;
+            } else {
+                plan.redundant.push_back(roads[i]);
+            }
+        }
+        return plan;
+    }
+
+public:
+    static const size_t PARALLEL_FROM = 200000; // Roads needed before threads pay off
+
+    // Sort all roads by budget and take each one that joins two separate groups
+    static NetworkPlan kruskal(const vector<PlannedRoad> &roads, int cityCount) {
+        vector<int> order(roads.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = static_cast<int>(i);
+        sort(order.begin(), order.end(), [&](int i, int j) { return cheaper(roads, i, j); });
+        UnionFind groups;
+        groups.reset(cityCount);
+        vector<char> inForest(roads.size(), 0);
+        for (int i : order) {
+            if (groups.unite(roads[i].a, roads[i].b)) inForest[i] = 1;
+        }
+        return collect(roads, inForest);
+    }
+
+    // Every round, each group picks its cheapest road out (threads scan slices of the
+    // road list), then all those roads get added at once. Groups at least halve per round.
+    static NetworkPlan boruvka(const vector<PlannedRoad> &roads, int cityCount, unsigned threadCount) {
+        threadCount = max(1u, threadCount);
+        UnionFind groups;
+        groups.reset(cityCount);
+        vector<int> group(cityCount); // City -> its group's root for this round
+        vector<atomic<int>> best(cityCount); // Group root -> cheapest road out, -1 if none
+        vector<char> inForest(roads.size(), 0);
+        int roadCount = static_cast<int>(roads.size());
+        while (true) {
+            for (int v = 0; v < cityCount; ++v) {
+                group[v] = groups.find(v);
+                best[v].store(-1, memory_order_relaxed);
+            }
+            auto scan = [&](int from, int to) {
+                for (int i = from; i < to; ++i) {
+                    int ga = group[roads[i].a], gb = group[roads[i].b];
+                    if (ga == gb) continue; // Already joined, this road would make a loop
+                    for (int g : {ga, gb}) {
+                        int current = best[g].load(memory_order_relaxed);
+                        while ((current == -1 || cheaper(roads, i, current)) &&
+                               !best[g].compare_exchange_weak(current, i, memory_order_relaxed)) {
+                        }
+                    }
+                }
+            };
+            vector<thread> workers;
+            int chunk = (roadCount + static_cast<int>(threadCount) - 1) / static_cast<int>(threadCount);
+            for (unsigned t = 0; t < threadCount; ++t) {
+                int from = min(roadCount, static_cast<int>(t) * chunk);
+                int to = min(roadCount, from + chunk);
+                if (from < to) workers.emplace_back(scan, from, to);
+            }
+            for (thread &worker : workers) worker.join();
+            bool merged = false;
+            for (int v = 0; v < cityCount; ++v) {
+                int i = best[v].load(memory_order_relaxed);
+                if (i != -1 && groups.unite(roads[i].a, roads[i].b)) {
+                    inForest[i] = 1;
+                    merged = true;
+                }
+            }
+            if (!merged) break; // No group has a road out anymore
+        }
+        return collect(roads, inForest);
+    }
+
+    // Pick the right planner for the size of the network
+    static NetworkPlan plan(const vector<PlannedRoad> &roads, int cityCount) {
+        if (roads.size() >= PARALLEL_FROM) return boruvka(roads, cityCount, thread::hardware_concurrency());
+        return kruskal(roads, cityCount);
+    }
+};
+
+// One city the way the save files store it
+struct SavedCity {
+    int index;
+    string name;
+    string area; // Full path like "Southern/Huye", "" if not placed
+    double latitude, longitude; // NAN if it has no position
+};
+
+// Everything a checkpoint writes, copied out of the live graph in one go. The copy
+// never changes afterwards, so the writer thread can take its time with it while
+// the operator keeps editing.
+struct SaveJob {
+    uint64_t number = 0; // Checkpoint number, goes up by one each time
+    vector<SavedCity> cities; // In ID order
+    vector<PlannedRoad> roads; // Each road once, smaller ID first
+    int nextIndex = 0;
+};
+
+// Writes checkpoints on its own thread, so nobody waits for the disk. If edits come
+// in faster than the disk keeps up, a checkpoint still waiting its turn is simply
+// replaced by the newer one (it holds everything the old one did): a burst of
+// saves turns into a single write. Those skipped saves are counted as coalesced.
+class BackgroundSaver {
+private:
+    Journal &journal; // Its set-aside records go once their checkpoint is on disk
+    LatencyStats &writeTimes; // How long each write to disk took
+    mutable mutex lock; // Guards everything below
+    condition_variable wake; // A new job arrived, or we're stopping
+    condition_variable idle; // A write finished
+    shared_ptr<const SaveJob> waiting; // The next job to write, null if none
+    bool writing = false; // Is the thread busy with a job right now?
+    bool stopping = false;
+    bool failed = false; // Did a write fail since someone last asked?
+    uint64_t lastNumber = 0; // Number of the newest checkpoint handed to us
+    size_t requested = 0, written = 0, coalesced = 0;
+    thread worker; // Started with the first job
+
+    static bool writeCities(const SaveJob &job) {
+        return replaceFile("cities.txt", [&](ofstream &out) {
+            out << CHECKPOINT_NOTE << job.number << "\n"; // Which save this is, for the loader
+            out << "index,city_name,area,latitude,longitude\n"; // Header for the file
+            out << fixed << setprecision(6); // Positions to about 10 cm
+            for (const SavedCity &city : job.cities) {
+                out << city.index << "," << city.name; // Write each city
+                if (!city.area.empty() || !isnan(city.latitude)) out << "," << city.area; // And where it sits, if known
+                if (!isnan(city.latitude)) out << "," << city.latitude << "," << city.longitude;
+                out << "\n";
+            }
+        });
+    }
+
+    static bool writeRoads(const SaveJob &job) {
+        return replaceFile("roads.txt", [&](ofstream &out) {
+            out << CHECKPOINT_NOTE << job.number << "\n";
+            out << "road,budget\n"; // Header
+            out << fixed << setprecision(2);
+            for (const PlannedRoad &road : job.roads) out << road.a << "-" << road.b << "," << road.budget << "\n";
+        });
+    }
+
+    // network.bin: a city table, a pool of all names and a flat road array
+    static bool writeSnapshot(const SaveJob &job) {
+        vector<SnapshotCity> table;
+        string pool;
+        table.reserve(job.cities.size());
+        for (const SavedCity &city : job.cities) {
+            table.push_back({city.index, static_cast<uint32_t>(city.name.size()), pool.size(),
+                             static_cast<uint32_t>(city.area.size()), 0, city.latitude, city.longitude});
+            pool += city.name;
+            pool += city.area;
+        }
+        vector<SnapshotRoad> roads;
+        roads.reserve(job.roads.size());
+        for (const PlannedRoad &road : job.roads) roads.push_back({road.a, road.b, road.budget});
+
+        // Lay the body out in one buffer so we can checksum it before writing
+        size_t tableBytes = table.size() * sizeof(SnapshotCity);
+        size_t roadsAt = alignTo8(tableBytes + pool.size());
+        vector<char> body(roadsAt + roads.size() * sizeof(SnapshotRoad), 0);
+        if (!table.empty()) memcpy(body.data(), table.data(), tableBytes);
+        if (!pool.empty()) memcpy(body.data() + tableBytes, pool.data(), pool.size());
+        if (!roads.empty()) memcpy(body.data() + roadsAt, roads.data(), roads.size() * sizeof(SnapshotRoad));
+
+        SnapshotHeader header{};
+        memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+        header.version = SNAPSHOT_VERSION;
+        header.headerSize = sizeof(SnapshotHeader);
+        header.cityCount = table.size();
+        header.stringBytes = pool.size();
+        header.roadCount = roads.size();
+        header.nextIndex = job.nextIndex;
+        header.checkpoint = job.number;
+        header.checksum = checksum64(body.data(), body.size());
+        return replaceFile("network.bin", [&](ofstream &out) {
+            out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            out.write(body.data(), static_cast<streamsize>(body.size()));
+        }, ios::out | ios::binary);
+    }
+
+    // The text files first, then the binary snapshot. Swapping in network.bin is the
+    // moment the checkpoint counts: it holds the cities, the roads and the checkpoint
+    // number in one file, so a crash before that rename loads the previous network.bin
+    // (and its journal records), and a crash after it loads the new one. The text files
+    // carry the number too and are only read when network.bin can't be.
+    static bool writeAll(const SaveJob &job) {
+        if (!writeCities(job) || !writeRoads(job) || !writeSnapshot(job)) return false;
+        error_code ec;
+        filesystem::remove("checkpoint.txt", ec); // Older versions kept the number there
+        return true;
+    }
+
+    void run() {
+        unique_lock<mutex> guard(lock);
+        while (true) {
+            wake.wait(guard, [&] { return waiting || stopping; });
+            if (!waiting) return; // Stopping, and nothing left to write
+            shared_ptr<const SaveJob> job = move(waiting);
+            waiting.reset();
+            writing = true;
+            guard.unlock();
+            auto start = chrono::steady_clock::now();
+            bool ok = writeAll(*job);
+            writeTimes.record(static_cast<uint64_t>(
+                chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count()));
+            guard.lock();
+            writing = false;
+            if (ok) {
+                written++;
+                // Only when nothing newer is queued: its records are set aside too
+                if (job->number == lastNumber) journal.dropSetAside();
+            } else {
+                failed = true; // The set-aside records stay, the next load replays them
+            }
+            idle.notify_all();
+        }
+    }
+
+public:
+    BackgroundSaver(Journal &changeLog, LatencyStats &writeStats) : journal(changeLog), writeTimes(writeStats) {}
+
+    ~BackgroundSaver() {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        if (worker.joinable()) worker.join(); // Finishes any job still waiting first
+    }
+
+    // Hand over a checkpoint. The journal's records so far are set aside under its
+    // number in the same step, so no edit can slip in between the copy and the journal.
+    void submit(shared_ptr<SaveJob> job) {
+        {
+            lock_guard<mutex> guard(lock);
+            job->number = ++lastNumber;
+            journal.setAside(job->number);
+            requested++;
+            if (waiting) coalesced++; // Never started, the new one covers it
+            waiting = move(job);
+            if (!worker.joinable()) worker = thread([this] { run(); });
+        }
+        wake.notify_one();
+    }
+
+    // Flush barrier: wait until every checkpoint handed over so far is on disk (or failed)
+    void flush() {
+        unique_lock<mutex> guard(lock);
+        idle.wait(guard, [&] { return !waiting && !writing; });
+    }
+
+    // Did a write fail since the last time we asked? Clears the flag.
+    bool takeFailure() {
+        lock_guard<mutex> guard(lock);
+        bool wasFailed = failed;
+        failed = false;
+        return wasFailed;
+    }
+
+    // Carry on numbering after the checkpoints found on disk at startup
+    void startNumberingAfter(uint64_t number) {
+        lock_guard<mutex> guard(lock);
+        lastNumber = max(lastNumber, number);
+    }
+
+    // Saves asked for, actually written, and skipped because a newer one replaced them
+    void counts(size_t &asked, size_t &done, size_t &skipped) const {
+        lock_guard<mutex> guard(lock);
+        asked = requested;
+        done = written;
+        skipped = coalesced;
+    }
+};
+
+// A frozen, read-only copy of the whole network for concurrent readers. Once built it
+// never changes, so any number of threads can query it without locks while the live
+// CityGraph keeps getting edited; edits publish a fresh copy with a higher version.
+struct GraphSnapshot {
+    uint64_t version = 0; // Goes up by one for every published change
+    vector<string> names; // City ID -> name, "" where there's no city
+    unordered_map<string, int> nameIndex; // Name -> city ID
+    RoadSnapshot roads; // All roads in CSR form
+    vector<int> component; // City ID -> cluster ID (-1 where there's no city)
+    size_t components = 0; // Number of separate clusters
+    int highestId = 0; // Highest ID that has a city, 0 if there are none
+
+    bool hasCity(int index) const {
+        return index >= 0 && index < static_cast<int>(names.size()) && !names[index].empty();
+    }
+};
+
+// A prefix tree of city names, so typing "Mu" finds Muhanga and Musanze without
+// checking every city. Letters are lowercased, so "mu" works too.
+class NameTrie {
+private:
+    struct Node {
+        vector<pair<char, int>> children; // Next letter -> node, kept sorted (A to Z results)
+        vector<int> cities; // Cities whose name ends right here
+    };
+    vector<Node> nodes{1}; // nodes[0] is the root
+
+    static char fold(char c) { return static_cast<char>(tolower(static_cast<unsigned char>(c))); }
+
+    // Follow the letters of key; -1 if the path doesn't exist (and create is false)
+    int walk(const string &key, bool create) {
+        int node = 0;
+        for (char raw : key) {
+            char c = fold(raw);
+            auto &children = nodes[node].children;
+            auto it = lower_bound(children.begin(), children.end(), make_pair(c, INT_MIN));
+            if (it != children.end() && it->first == c) {
+                node = it->second;
+            } else if (create) {
+                int child = static_cast<int>(nodes.size());
+                children.insert(it, {c, child});
+                nodes.emplace_back(); // Careful: this may move "children", so we're done with it
+                node = child;
+            } else {
+                return -1;
+            }
+        }
+        return node;
+    }
+
+public:
+    void insert(const string &name, int index) {
+        nodes[walk(name, true)].cities.push_back(index);
+    }
+
+    void erase(const string &name, int index) {
+        int node = walk(name, false);
+        if (node == -1) return;
+        auto &list = nodes[node].cities;
+        list.erase(remove(list.begin(), list.end(), index), list.end());
+    }
+
+    size_t memoryBytes() const {
+        size_t bytes = nodes.capacity() * sizeof(Node);
+        for (const Node &node : nodes) {
+            bytes += node.children.capacity() * sizeof(pair<char, int>) + node.cities.capacity() * sizeof(int);
+        }
+        return bytes;
+    }
+
+    // Up to limit city indexes whose name starts with prefix, in alphabetical order
+    vector<int> withPrefix(const string &prefix, size_t limit) {
+        vector<int> found;
+        int start = walk(prefix, false);
+        if (start == -1) return found;
+        vector<int> stack{start};
+        while (!stack.empty() && found.size() < limit) {
+            int node = stack.back();
+            stack.pop_back();
+            for (int index : nodes[node].cities) {
+                if (found.size() < limit) found.push_back(index);
+            }
+            // Push in reverse so the smallest letter is visited first
+            const auto &children = nodes[node].children;
+            for (auto it = children.rbegin(); it != children.rend(); ++it) stack.push_back(it->second);
+        }
+        return found;
+    }
+};
+
+// The big boss class that runs our Rwanda road show!
+class CityGraph {
+private:
+    CityTable cities; // Our city list, like numbered parking spots: ID -> city info
+    unordered_map<string, int> nameIndex; // The phonebook the other way round: name -> ID
+    NameTrie namePrefixes; // For "starts with" searches
+    AdminTree areas; // Provinces, districts, sectors, cells and villages
+    RouteEngine routes; // Cheapest-route searches, with a cache of recent ones
+    ContractionHierarchy hierarchy; // Shortcuts for instant routes on big networks
+    bool hierarchyStale = true; // Roads changed since the hierarchy was built?
+    bool hierarchyFailed = false; // Did the last build give up (too much work)? Then "auto" waits for road edits to retry
+    static const size_t HIERARCHY_FROM = 5000; // Below this many cities plain Dijkstra is quick enough
+    CityLocator locator; // k-d tree of city positions for "nearest" and "within" questions
+    bool locatorStale = true; // Positions changed since the tree was built?
+    vector<array<double, 3>> ballOf; // City ID -> its position on the unit ball, for A* guesses
+    double kmRate = -1; // Cheapest budget per straight-line km of any road, -1 = A* can't be used
+    bool kmRateStale = true; // Roads or positions changed since kmRate was worked out?
+    UnionFind connectivity; // Which cities can reach each other, kept up to date on every new road
+    bool connectivityStale = false; // Roads were deleted in a batch, regroup before the next question
+    mutable OpMetrics metrics; // How often each operation ran and how long it took
+    string statsFile; // If set, the stats get written here when we close
+    RoadNetwork network; // Who is connected to who, plus road budgets (sparse)
+    BudgetLedger ledger; // Budget totals and rankings, kept current on every edit
+    int nextIndex; // Keeps track of the next city ID, like a ticket number
+    Journal journal{"journal.txt"}; // Every change since the last checkpoint
+    static const size_t CHECKPOINT_EVERY = 1000; // Fold the journal into the files this often
+    bool unsaved = false; // Anything changed since the last checkpoint?
+    bool batchMode = false; // In a batch we skip the journal and save once at the end
+    // Writes the checkpoints on its own thread. Declared last so it's the first to go
+    // when we close, finishing its last write while everything else is still around.
+    BackgroundSaver saver{journal, metrics[static_cast<size_t>(Op::SaveWrite)]};
+
+    // Add or rename a city, keeping the name lookups in sync with the city list
+    void setCity(int index, const string &name) {
+        forgetName(index);
+        cities.put(index, name);
+        nameIndex[name] = index;
+        namePrefixes.insert(name, index);
+    }
+
+    // Take a city's current name out of the name lookups (before a rename or delete)
+    void forgetName(int index) {
+        if (!cities.has(index)) return;
+        const string &oldName = cities[index].name;
+        auto named = nameIndex.find(oldName);
+        if (named != nameIndex.end() && named->second == index) nameIndex.erase(named);
+        namePrefixes.erase(oldName, index);
+    }
+
+    // Take a city and all its roads off the map; its ID goes on the free list
+    void dropCity(int index) {
+        vector<Road> roads = network.neighbors(index); // A copy, we're removing from the real list
+        for (const Road &road : roads) {
+            network.removeRoad(index, road.to);
+            ledger.roadRemoved(index, road.to);
+        }
+        forgetName(index);
+        cities.remove(index);
+        locatorStale = kmRateStale = true;
+    }
+
+    // Forget every city, before loading saved files over the starting ones
+    void clearCities() {
+        cities.assign({});
+        nameIndex.clear();
+        namePrefixes = NameTrie();
+    }
+
+    // Write one change to the journal, and checkpoint once it gets long
+    void logChange(const string &record) {
+        unsaved = true;
+        if (batchMode) return; // The batch saves everything in one go when it's done
+        {
+            OpTimer timer(metrics, Op::Journal);
+            journal.append(record);
+        }
+        if (journal.size() >= CHECKPOINT_EVERY) saveData();
+    }
+
+    // Redo one journal record on top of the loaded files; false only if it can't be read.
+    // The files may already hold a record (a checkpoint got to the disk but the journal
+    // wasn't cleared yet), so a record whose city or road is already gone is skipped
+    // instead of failing: replaying twice must always be harmless.
+    bool applyRecord(const vector<string> &fields) {
+        if (fields.empty()) return false;
+        try {
+            const string &type = fields[0];
+            if ((type == "C" || type == "E") && fields.size() == 3) { // New or renamed city
+                int index = stoi(fields[1]);
+                if (index < 0) return false;
+                setCity(index, fields[2]);
+                nextIndex = max(nextIndex, index + 1);
+                resizeRoadStorage();
+                return true;
+            }
+            if (type == "R" && fields.size() == 3) { // New road
+                int city1 = stoi(fields[1]), city2 = stoi(fields[2]);
+                // Already there is fine; a city deleted later on means the road went with it
+                if (cities.has(city1) && cities.has(city2)) network.addRoad(city1, city2);
+                return true;
+            }
+            if (type == "B" && fields.size() == 4) { // Budget for a road
+                network.setBudget(stoi(fields[1]), stoi(fields[2]), stod(fields[3])); // No road (any more) is fine
+                return true;
+            }
+            if (type == "A" && fields.size() == 3) { // City placed in an area
+                int index = stoi(fields[1]), area = areas.place(fields[2]);
+                if (area == -1) return false;
+                if (cities.has(index)) cities[index].area = area;
+                return true;
+            }
+            if (type == "G" && fields.size() == 4) { // City position
+                int index = stoi(fields[1]);
+                double latitude = stod(fields[2]), longitude = stod(fields[3]);
+                if (!validPosition(latitude, longitude)) return false;
+                if (cities.has(index)) {
+                    cities[index].latitude = latitude;
+                    cities[index].longitude = longitude;
+                }
+                return true;
+            }
+            if (type == "D" && fields.size() == 2) { // Deleted city
+                int index = stoi(fields[1]);
+                if (cities.has(index)) dropCity(index); // Already gone is fine
+                return true;
+            }
+            if (type == "X" && fields.size() == 3) { // Deleted road
+                network.removeRoad(stoi(fields[1]), stoi(fields[2])); // Already gone is fine
+                return true;
+            }
+        } catch (...) {
+        }
+        return false;
+    }
+
+public:
+    // Setting up the app, like opening a new shop in Kigali
+    CityGraph() : nextIndex(8) {
+        // Start with 7 awesome Rwandan cities
+        setCity(1, "Kigali");
+        setCity(2, "Huye");
+        setCity(3, "Muhanga");
+        setCity(4, "Musanze");
+        setCity(5, "Nyagatare");
+        setCity(6, "Rubavu");
+        setCity(7, "Rusizi");
+        // Get our road storage ready
+        resizeRoadStorage();
+        // Load any saved data, like picking up where we left off
+        loadData();
+    }
+
+    // Clean up when we’re done, like locking the shop
+    ~CityGraph() {
+        if (unsaved) saveData(); // Fold the journal into the files before we go
+        flushSaves(); // And wait for the disk, or the last changes would only be in the journal
+        if (!statsFile.empty()) {
+            ofstream out(statsFile);
+            writeStats(out);
+        }
+    }
+
+    // Dump the stats to this file when the app closes ("" = don't)
+    void setStatsFile(const string &path) { statsFile = path; }
+
+    // Make room in the road storage for new cities (one empty list per city)
+    void resizeRoadStorage() {
+        OpTimer timer(metrics, Op::Resize);
+        network.resize(max(nextIndex, 8)); // At least 8 to handle our starting cities
+        connectivity.resize(network.size());
+    }
+
+    // ", Area: Southern/Huye, Position: -2.5967, 29.7394" for whatever we know about a city
+    string placeNote(int index) const {
+        const City &city = cities.at(index);
+        ostringstream note;
+        if (city.area != -1) note << ", Area: " << areas.pathOf(city.area);
+        if (city.located()) note << ", Position: " << fixed << setprecision(4) << city.latitude << ", " << city.longitude;
+        return note.str();
+    }
+
+    // Find a city's index by its exact name, -1 if nobody has that name
+    int findCityByName(const string &name) const {
+        OpTimer timer(metrics, Op::Search);
+        auto it = nameIndex.find(name);
+        return it == nameIndex.end() ? -1 : it->second;
+    }
+
+    // Cities whose names start with prefix (any case), alphabetical, at most limit of them
+    vector<int> findCitiesByPrefix(const string &prefix, size_t limit = 20) {
+        OpTimer timer(metrics, Op::Search);
+        return namePrefixes.withPrefix(prefix, limit);
+    }
+
+    // The core edits below are shared by the menu and batch mode.
+    // Each one returns "" when all went well, or the error message to show.
+
+    // Put a new city on the map and hand back its fresh index
+    string insertCity(const string &name, int &newIndex) {
+        OpTimer timer(metrics, Op::AddCity);
+        if (findCityByName(name) != -1) {
+            return "City named '" + name + "' already exists!"; // No duplicates!
+        }
+        newIndex = cities.takeFreeId(); // Reuse the ID of a deleted city if there is one
+        if (newIndex == -1) newIndex = nextIndex++; // Otherwise next ID, please!
+        setCity(newIndex, name); // Add the new city
+        resizeRoadStorage(); // Make room for the new city's roads
+        logChange("C," + to_string(newIndex) + "," + name); // Jot it in the journal so we don’t lose it
+        return "";
+    }
+
+    // Is there a road we can put money on between these two?
+    string checkRoad(int city1, int city2) {
+        if (!cities.has(city1) || !cities.has(city2)) {
+            return "One or both cities do not exist!"; // Need real cities
+        }
+        if (!network.hasRoad(city1, city2)) {
+            return "No road exists between " + cities[city1].name + " and " + cities[city2].name + "!"; // Build the road first!
+        }
+        return "";
+    }
+
+    // Build a two-way road between two existing cities
+    string connectCities(int city1, int city2) {
+        OpTimer timer(metrics, Op::AddRoad);
+        if (!cities.has(city1) || !cities.has(city2)) {
+            return "One or both cities do not exist!"; // Gotta pick real cities!
+        }
+        if (city1 == city2) {
+            return "Cannot add a road from a city to itself!"; // No looping roads!
+        }
+        if (!network.addRoad(city1, city2)) { // Build that road both ways
+            return "Road between " + cities[city1].name + " and " + cities[city2].name + " already exists!"; // No double roads!
+        }
+        routes.roadChanged(network, city1, city2, numeric_limits<double>::infinity(), 0.0);
+        hierarchyStale = kmRateStale = true;
+        ledger.roadAdded(city1, city2, 0.0);
+        connectivity.unite(city1, city2);
+        logChange("R," + to_string(city1) + "," + to_string(city2)); // Jot it in the journal
+        return "";
+    }
+
+    // Put a budget (billions of RWF) on an existing road
+    string assignBudget(int city1, int city2, double budget) {
+        OpTimer timer(metrics, Op::SetBudget);
+        string error = checkRoad(city1, city2);
+        if (!error.empty()) return error;
+        if (budget < 0) return "Budget cannot be negative!";
+        double oldBudget = network.budget(city1, city2);
+        network.setBudget(city1, city2, budget); // Set budget both ways
+        routes.roadChanged(network, city1, city2, oldBudget, budget);
+        hierarchyStale = kmRateStale = true;
+        ledger.budgetChanged(city1, city2, budget);
+        ostringstream record;
+        record << "B," << city1 << "," << city2 << "," << fixed << setprecision(2) << budget;
+        logChange(record.str()); // Jot it in the journal
+        return "";
+    }
+
+    // Give a city a new name, as long as nobody else has it
+    string renameCity(int index, const string &newName) {
+        OpTimer timer(metrics, Op::EditCity);
+        if (!cities.has(index)) {
+            return "City with index " + to_string(index) + " does not exist!"; // Wrong ID!
+        }
+        int owner = findCityByName(newName);
+        if (owner != -1 && owner != index) {
+            return "City named '" + newName + "' already exists!"; // No duplicates!
+        }
+        setCity(index, newName); // Update the name
+        logChange("E," + to_string(index) + "," + newName); // Jot the change in the journal
+        return "";
+    }
+
+    // Put a city in the administrative map, like "Southern/Huye/Ngoma" (province
+    // first, down to village at most). Missing units are created on the way.
+    string placeCity(int index, const string &path) {
+        OpTimer timer(metrics, Op::EditCity);
+        if (!cities.has(index)) {
+            return "City with index " + to_string(index) + " does not exist!"; // Wrong ID!
+        }
+        int area = areas.place(path);
+        if (area == -1) {
+            return "Area '" + path + "' is not a valid path (like Southern/Huye/Ngoma, at most " +
+                   to_string(ADMIN_DEPTH) + " levels)!";
+        }
+        cities[index].area = area;
+        logChange("A," + to_string(index) + "," + areas.pathOf(area)); // Jot it in the journal
+        return "";
+    }
+
+    // Pin a city on the map, latitude then longitude in degrees (Kigali is about -1.9441, 30.0619)
+    string setLocation(int index, double latitude, double longitude) {
+        OpTimer timer(metrics, Op::EditCity);
+        if (!cities.has(index)) {
+            return "City with index " + to_string(index) + " does not exist!"; // Wrong ID!
+        }
+        if (!validPosition(latitude, longitude)) {
+            return "Latitude must be between -90 and 90 and longitude between -180 and 180!";
+        }
+        cities[index].latitude = latitude;
+        cities[index].longitude = longitude;
+        locatorStale = kmRateStale = true;
+        ostringstream record;
+        record << "G," << index << "," << fixed << setprecision(6) << latitude << "," << longitude;
+        logChange(record.str()); // Jot it in the journal
+        return "";
+    }
+
+    // Rebuild the k-d tree if positions changed since last time. A batch of edits costs
+    // one rebuild, done when the next nearby question comes in.
+    void refreshLocator() {
+        if (!locatorStale) return;
+        locator.build(cities);
+        locatorStale = false;
+    }
+
+    // The k cities closest to a position (closest first, as km and city ID), leaving
+    // out skip (the city we're asking about, if any)
+    vector<pair<double, int>> nearestCities(double latitude, double longitude, size_t k, int skip = -1) {
+        OpTimer timer(metrics, Op::Nearby);
+        refreshLocator();
+        vector<pair<double, int>> found = locator.nearest(latitude, longitude, skip == -1 ? k : k + 1);
+        found.erase(remove_if(found.begin(), found.end(), [&](const pair<double, int> &hit) { return hit.second == skip; }),
+                    found.end());
+        if (found.size() > k) found.resize(k);
+        return found;
+    }
+
+    // Every city within km of a position (closest first), leaving out skip
+    vector<pair<double, int>> citiesWithin(double latitude, double longitude, double km, int skip = -1) {
+        OpTimer timer(metrics, Op::Nearby);
+        refreshLocator();
+        vector<pair<double, int>> found = locator.within(latitude, longitude, km);
+        found.erase(remove_if(found.begin(), found.end(), [&](const pair<double, int> &hit) { return hit.second == skip; }),
+                    found.end());
+        return found;
+    }
+
+    // Print a list of nearby cities under a title
+    void showNearby(const string &title, const vector<pair<double, int>> &found) {
+        const size_t SHOW = 50;
+        ScreenBuffer out;
+        out.add("\n--- ").add(title).add(" ---\n");
+        for (size_t i = 0; i < found.size() && i < SHOW; ++i) {
+            out.add("  ").add(cities[found[i].second].name).add(" (").number(found[i].second).add(") | ")
+               .money(found[i].first).add(" km\n");
+        }
+        if (found.size() > SHOW) out.add("  ... and ").number(static_cast<long long>(found.size() - SHOW)).add(" more\n");
+        if (found.empty()) out.add("  (no cities with a position there)\n");
+        out.flush();
+    }
+
+    // Roll the road budgets up to every unit at one level (0 = province ... 4 = village),
+    // optionally only units inside `within`. One pass over the cities and one over the roads.
+    vector<AreaTotal> areaTotals(int level, int within = -1) const {
+        vector<int> unitOf(cities.slotCount(), -2); // City -> its unit at this level, -2 = left out
+        vector<int> slot(areas.size(), -1); // Unit -> its row in the result
+        vector<AreaTotal> totals{AreaTotal{-1}}; // Row 0: cities with no unit at this level
+        auto rowOf = [&](int unit) {
+            if (unit == -1) return 0;
+            if (slot[unit] == -1) {
+                slot[unit] = static_cast<int>(totals.size());
+                totals.push_back(AreaTotal{unit});
+            }
+            return slot[unit];
+        };
+        for (const City &city : cities) {
+            int unit = areas.ancestorAt(city.area, level);
+            if (within != -1 && !areas.isInside(city.area, within)) continue; // Not part of this report
+            unitOf[city.index] = unit;
+            totals[rowOf(unit)].cities++;
+        }
+        for (const City &city : cities) {
+            int a = city.index;
+            for (const Road &road : network.neighbors(a)) {
+                int b = road.to;
+                if (b < a || !cities.has(b)) continue; // Each road once
+                bool aCounted = unitOf[a] != -2, bCounted = unitOf[b] != -2;
+                if (aCounted && unitOf[a] == unitOf[b]) {
+                    AreaTotal &total = totals[rowOf(unitOf[a])];
+                    total.roads++;
+                    total.inside += road.budget;
+                    continue;
+                }
+                for (int end : {a, b}) {
+                    if (!(end == a ? aCounted : bCounted)) continue;
+                    AreaTotal &total = totals[rowOf(unitOf[end])];
+                    total.roads++;
+                    total.border += road.budget;
+                }
+            }
+        }
+        if (totals[0].cities == 0 && totals[0].roads == 0) totals.erase(totals.begin()); // Everyone is placed
+        sort(totals.begin(), totals.end(), [&](const AreaTotal &x, const AreaTotal &y) {
+            if ((x.unit == -1) != (y.unit == -1)) return y.unit == -1; // "No area" goes last
+            return areas.pathOf(x.unit) < areas.pathOf(y.unit);
+        });
+        return totals;
+    }
+
+    // Print the budget roll-up for one level, e.g. every district (inside `withinPath` if given)
+    string showAreaBudgets(int level, const string &withinPath = "") {
+        OpTimer timer(metrics, Op::Display);
+        int within = -1;
+        if (!withinPath.empty()) {
+            within = areas.find(withinPath);
+            if (within == -1) return "Area '" + withinPath + "' not found!";
+            if (areas.levelOf(within) >= level) return "Area '" + withinPath + "' is not above " + ADMIN_LEVELS[level] + " level!";
+        }
+        ScreenBuffer out;
+        out.add("\n--- Road budgets by ").add(ADMIN_LEVELS[level]);
+        if (within != -1) out.add(" in ").add(areas.pathOf(within));
+        out.add(" (billions RWF) ---\n");
+        for (const AreaTotal &total : areaTotals(level, within)) {
+            out.add(total.unit == -1 ? "(no " + string(ADMIN_LEVELS[level]) + ")" : areas.pathOf(total.unit))
+               .add(": ").number(static_cast<long long>(total.cities)).add(" cities, ")
+               .number(static_cast<long long>(total.roads)).add(" roads, inside ").money(total.inside)
+               .add(", border ").money(total.border).add("\n");
+        }
+        out.flush();
+        return "";
+    }
+
+    // National total, the k priciest roads and the k cities with the most money on
+    // their roads. All of it comes from the ledger, no walk over the road lists.
+    void showBudgetReport(size_t k) {
+        OpTimer timer(metrics, Op::Display);
+        ScreenBuffer out;
+        out.add("\n--- Budget Report (billions RWF) ---\n");
+        out.add("National total: ").money(ledger.total()).add(" on ").number(static_cast<long long>(ledger.roads()))
+           .add(" roads\n");
+        out.add("\nMost expensive roads:\n");
+        int rank = 0;
+        for (int slot : ledger.topRoads(k)) {
+            auto [a, b] = ledger.road(slot);
+            out.number(++rank, 4).add(". ").add(cities[a].name).add(" - ").add(cities[b].name).add(" | ")
+               .money(ledger.budget(slot)).add("\n");
+        }
+        out.add("\nCities with the most budget on their roads:\n");
+        rank = 0;
+        for (int city : ledger.topCities(k)) {
+            out.number(++rank, 4).add(". ").add(cities[city].name).add(" (").number(city).add(") | ")
+               .money(ledger.cityBudget(city)).add("\n");
+        }
+        out.flush();
+    }
+
+    // Every road with a budget between low and high (inclusive), a screenful at most
+    string showBudgetRange(double low, double high) {
+        OpTimer timer(metrics, Op::Display);
+        if (low > high) return "The lowest budget can't be above the highest!";
+        const size_t SHOW = 50;
+        auto [count, sum] = ledger.countInRange(low, high);
+        ScreenBuffer out;
+        out.add("\nRoads with a budget from ").money(low).add(" to ").money(high).add(" billion RWF: ")
+           .number(static_cast<long long>(count)).add(" roads, ").money(sum).add(" in total\n");
+        for (int slot : ledger.roadsInRange(low, high, SHOW)) {
+            auto [a, b] = ledger.road(slot);
+            out.add("  ").add(cities[a].name).add(" - ").add(cities[b].name).add(" | ").money(ledger.budget(slot)).add("\n");
+        }
+        if (count > SHOW) out.add("  ... and ").number(static_cast<long long>(count - SHOW)).add(" more\n");
+        out.flush();
+        return "";
+    }
+
+    // Take a city off the map, along with every road touching it. Its ID is free
+    // for the next new city (run compaction instead if you'd rather close the gap).
+    string deleteCity(int index) {
+        OpTimer timer(metrics, Op::Delete);
+        if (!cities.has(index)) {
+            return "City with index " + to_string(index) + " does not exist!"; // Wrong ID!
+        }
+        dropCity(index);
+        routes.clear(); // Cached routes may pass through it
+        hierarchyStale = true;
+        regroupAfterDelete(); // Losing roads can split a cluster, union-find can't undo that
+        logChange("D," + to_string(index)); // Jot it in the journal
+        return "";
+    }
+
+    // Close the road between two cities
+    string deleteRoad(int city1, int city2) {
+        OpTimer timer(metrics, Op::Delete);
+        string error = checkRoad(city1, city2);
+        if (!error.empty()) return error;
+        double oldBudget = network.budget(city1, city2);
+        network.removeRoad(city1, city2);
+        ledger.roadRemoved(city1, city2);
+        // Like a road getting infinitely expensive: only routes that used it are dropped
+        routes.roadChanged(network, city1, city2, oldBudget, numeric_limits<double>::infinity());
+        hierarchyStale = kmRateStale = true;
+        regroupAfterDelete();
+        logChange("X," + to_string(city1) + "," + to_string(city2)); // Jot it in the journal
+        return "";
+    }
+
+    // Renumber the cities 1, 2, 3... in their current order so deleted IDs leave no
+    // gaps, rewriting every road in one pass. newId[old ID] is the new ID (-1 for IDs
+    // that had no city); it's also saved to id_map.txt for anyone holding old IDs.
+    string compactCities(vector<int> &newId) {
+        OpTimer timer(metrics, Op::Compact);
+        newId.assign(network.size(), -1);
+        vector<City> packed{{-1, ""}}; // ID 0 is never used
+        packed.reserve(cities.size() + 1);
+        for (const City &city : cities) { // Already in ID order
+            newId[city.index] = static_cast<int>(packed.size());
+            packed.push_back(city);
+            packed.back().index = newId[city.index];
+        }
+        network.renumber(newId, static_cast<int>(packed.size()));
+        clearCities();
+        nextIndex = static_cast<int>(packed.size());
+        for (const City &city : packed) {
+            if (city.index == -1) continue;
+            setCity(city.index, city.name);
+            cities[city.index] = city; // Area and position come along
+        }
+        resizeRoadStorage();
+        routes.clear(); // Every cached route is in old IDs
+        ledger.rebuild(network);
+        hierarchy = ContractionHierarchy(); // Its contraction order is in old IDs too
+        hierarchyStale = locatorStale = kmRateStale = true;
+        rebuildConnectivity();
+        bool mapSaved = replaceFile("id_map.txt", [&](ofstream &out) {
+            out << "old_index,new_index\n";
+            for (size_t old = 0; old < newId.size(); ++old) {
+                if (newId[old] != -1) out << old << "," << newId[old] << "\n";
+            }
+        });
+        unsaved = true;
+        // The journal talks in old IDs, so checkpoint right away (a batch saves at its end),
+        // and wait for it: new edits get journaled in new IDs, which only fit the new files
+        if (!batchMode) {
+            saveData();
+            if (!flushSaves()) return "Could not save the renumbered cities! Exit now (that tries the save again) before making more changes.";
+        }
+        return mapSaved ? "" : "Could not write id_map.txt!";
+    }
+
+    // Add new cities, like expanding Rwanda’s map!
+    void addCities() {
+        int numCities = readInt("Number of cities to add: ", 1); // How many cities we adding?
+        for (int i = 0; i < numCities; ++i) {
+            cout << "\nAdding city " << (i + 1) << " of " << numCities << "\n";
+            string name = readString("City name: "); // Get the city name
+            int index;
+            string error = insertCity(name, index);
+            if (!error.empty()) {
+                cout << "Error: " << error << "\n";
+                --i; // Try this one again
+                continue;
+            }
+            cout << "Added city '" << name << "' with index " << index << "\n"; // Woohoo!
+        }
+    }
+
+    // Connect two cities with a road, like building a new highway
+    void addRoad() {
+        int city1 = readInt("Enter first city index: ", 1, nextIndex - 1); // Pick city 1
+        int city2 = readInt("Enter second city index: ", 1, nextIndex - 1); // Pick city 2
+        string error = connectCities(city1, city2);
+        if (!error.empty()) {
+            cout << "Error: " << error << "\n";
+            return;
+        }
+        cout << "Added road between " << cities[city1].name << " (" << city1 << ") and "
+             << cities[city2].name << " (" << city2 << ")\n"; // Road’s ready!
+    }
+
+    // Set a budget for a road, like funding a new Kigali-Muhanga route
+    void addBudget() {
+        int city1 = readInt("Enter first city index: ", 1, nextIndex - 1);
+        int city2 = readInt("Enter second city index: ", 1, nextIndex - 1);
+        string error = checkRoad(city1, city2);
+        if (!error.empty()) {
+            cout << "Error: " << error << "\n";
+            return;
+        }
+        double budget = readInt("Enter budget (billions of RWF): ", 0) / 1.0; // Get budget in billions
+        assignBudget(city1, city2, budget);
+        cout << "Assigned budget of " << budget << " billion RWF to road between "
+             << cities[city1].name << " and " << cities[city2].name << "\n"; // Money allocated!
+    }
+
+    // Rename a city, like changing “Huye” to “Gisagara”
+    void editCity() {
+        int index = readInt("Enter city index to edit: ", 1, nextIndex - 1);
+        if (!cities.has(index)) {
+            cout << "Error: City with index " << index << " does not exist!\n"; // Wrong ID!
+            return;
+        }
+        string newName = readString("Enter new city name: "); // Get new name
+        string oldName = cities[index].name;
+        string error = renameCity(index, newName);
+        if (!error.empty()) {
+            cout << "Error: " << error << "\n";
+            return;
+        }
+        cout << "Changed city " << index << " from '" << oldName << "' to '" << newName << "'\n"; // Done!
+    }
+
+    // Delete a city and its roads, like a town merging into its neighbor
+    void removeCity() {
+        int index = readInt("Enter city index to delete: ", 1, nextIndex - 1);
+        if (!cities.has(index)) {
+            cout << "Error: City with index " << index << " does not exist!\n";
+            return;
+        }
+        string name = cities[index].name;
+        size_t roads = network.neighbors(index).size();
+        deleteCity(index);
+        cout << "Deleted city '" << name << "' (" << index << ") and its " << roads << " road(s)\n";
+    }
+
+    // Delete the road between two cities
+    void removeRoad() {
+        int city1 = readInt("Enter first city index: ", 1, nextIndex - 1);
+        int city2 = readInt("Enter second city index: ", 1, nextIndex - 1);
+        string error = deleteRoad(city1, city2);
+        if (!error.empty()) {
+            cout << "Error: " << error << "\n";
+            return;
+        }
+        cout << "Deleted road between " << cities[city1].name << " and " << cities[city2].name << "\n";
+    }
+
+    // Close the gaps left by deleted cities and tell the user how the IDs moved
+    void compactIds() {
+        vector<int> newId;
+        string error = compactCities(newId);
+        if (!error.empty()) cout << "Error: " << error << "\n";
+        size_t moved = 0;
+        for (size_t old = 0; old < newId.size(); ++old) moved += newId[old] != -1 && newId[old] != static_cast<int>(old);
+        cout << "Compacted city IDs: " << cities.size() << " cities now use IDs 1 to " << (nextIndex - 1) << ", "
+             << moved << " changed (old -> new IDs saved in id_map.txt)\n";
+    }
+
+    // Say where a city sits, like putting Huye in the Southern province
+    void placeCityInArea() {
+        int index = readInt("Enter city index: ", 1, nextIndex - 1);
+        string path = readString("Area, from province down (like Southern/Huye/Ngoma): ");
+        string error = placeCity(index, path);
+        if (!error.empty()) {
+            cout << "Error: " << error << "\n";
+            return;
+        }
+        cout << cities[index].name << " is now in " << areas.pathOf(cities[index].area) << "\n";
+    }
+
+    // Pin a city on the map by its latitude and longitude
+    void locateCity() {
+        int index = readInt("Enter city index: ", 1, nextIndex - 1);
+        if (!cities.has(index)) {
+            cout << "Error: City with index " << index << " does not exist!\n";
+            return;
+        }
+        double latitude = 0.0, longitude = 0.0;
+        string error;
+        while (true) {
+            string lat = readString("Latitude (like -1.9441): ");
+            string lon = readString("Longitude (like 30.0619): ");
+            if ((error = parsePosition(lat, lon, latitude, longitude)).empty()) break;
+            cout << "Error: " << error << "\n";
+        }
+        setLocation(index, latitude, longitude);
+        cout << cities[index].name << " is now at " << fixed << setprecision(4) << latitude << ", " << longitude << "\n";
+    }
+
+    // The closest cities to one city, then optionally everything within some km
+    void nearbyCities() {
+        int index = readInt("Enter city index: ", 1, nextIndex - 1);
+        if (!cities.has(index)) {
+            cout << "Error: City with index " << index << " does not exist!\n";
+            return;
+        }
+        double latitude = 0.0, longitude = 0.0;
+        string error = positionOf(index, latitude, longitude);
+        if (!error.empty()) {
+            cout << "Error: " << error << "\n";
+            return;
+        }
+        int k = readInt("How many of the nearest cities? ", 1);
+        showNearby(to_string(k) + " nearest cities to " + cities[index].name,
+                   nearestCities(latitude, longitude, static_cast<size_t>(k), index));
+        string answer = readString("Also list every city within some distance? (y/n): ");
+        if (answer != "y" && answer != "Y") return;
+        int km = readInt("Distance (km): ", 0);
+        showNearby("Cities within " + to_string(km) + " km of " + cities[index].name,
+                   citiesWithin(latitude, longitude, km, index));
+    }
+
+    // Road budget totals per province, district, sector...
+    void areaBudgets() {
+        int level;
+        while ((level = AdminTree::parseLevel(readString("Level (province, district, sector, cell or village): "))) == -1) {
+            cout << "Please type one of: province, district, sector, cell, village.\n";
+        }
+        showAreaBudgets(level);
+    }
+
+    // Budget report, then an optional look at the roads in a budget range
+    void budgetReport() {
+        showBudgetReport(10);
+        string answer = readString("Show roads in a budget range? (y/n): ");
+        if (answer != "y" && answer != "Y") return;
+        int low = readInt("From (billions RWF): ", 0);
+        int high = readInt("To (billions RWF): ", low);
+        showBudgetRange(low, high);
+    }
+
+    // Find a city by name, like looking up “Musanze”
+    void searchCity() {
+        string name = readString("Enter city name to search: ");
+        int index = findCityByName(name);
+        if (index != -1) {
+            cout << "Found: Index " << index << ", Name: " << cities[index].name << "\n"; // Got it!
+        } else {
+            cout << "Error: City named '" << name << "' not found!\n"; // Oops, not there!
+        }
+    }
+
+    // Turn "3" or "Muhanga" into a city index
+    string resolveCity(const string &token, int &index) {
+        string text = trim(token);
+        if (!text.empty() && all_of(text.begin(), text.end(), [](unsigned char c) { return isdigit(c); })) {
+            try {
+                index = stoi(text);
+            } catch (...) {
+                return "City index '" + text + "' is too big!";
+            }
+            if (!cities.has(index)) return "City with index " + text + " does not exist!";
+            return "";
+        }
+        index = findCityByName(text);
+        if (index == -1) return "City named '" + text + "' not found!";
+        return "";
+    }
+
+    // Turn "42" into a plain number, for things like ID ranges where gaps are fine
+    static string parseNumber(const string &token, int &value) {
+        string text = trim(token);
+        auto [next, error] = from_chars(text.data(), text.data() + text.size(), value);
+        if (error != errc() || next != text.data() + text.size()) return "'" + text + "' is not a whole number!";
+        return "";
+    }
+
+    // Turn "45.5" into a budget amount
+    static string parseBudget(const string &token, double &budget) {
+        string text = trim(token);
+        try {
+            size_t used;
+            budget = stod(text, &used);
+            if (used != text.size()) throw invalid_argument(text);
+        } catch (...) {
+            return "Budget '" + text + "' is not a number!";
+        }
+        return "";
+    }
+
+    // Turn "-1.9441" and "30.0619" into a map position
+    static string parsePosition(const string &latToken, const string &lonToken, double &latitude, double &longitude) {
+        string lat = trim(latToken), lon = trim(lonToken);
+        if (!readDouble(lat, latitude)) return "Latitude '" + lat + "' is not a number!";
+        if (!readDouble(lon, longitude)) return "Longitude '" + lon + "' is not a number!";
+        if (!validPosition(latitude, longitude)) return "Latitude must be between -90 and 90 and longitude between -180 and 180!";
+        return "";
+    }
+
+    // The position of a city we want to look around, or an error if it has none
+    string positionOf(int index, double &latitude, double &longitude) {
+        if (!cities[index].located()) return cities[index].name + " has no position yet (set-location first)!";
+        latitude = cities[index].latitude;
+        longitude = cities[index].longitude;
+        return "";
+    }
+
+    // Run one batch command, already split on commas; "" means it worked
+    string runCommand(const vector<string> &fields) {
+        string command = trim(fields[0]);
+        int city1, city2;
+        string error;
+        if (command == "add-city" && fields.size() == 2) {
+            string name = trim(fields[1]);
+            if (name.empty()) return "City name cannot be empty!";
+            return insertCity(name, city1);
+        }
+        if (command == "add-road" && (fields.size() == 3 || fields.size() == 4)) {
+            if (!(error = resolveCity(fields[1], city1)).empty()) return error;
+            if (!(error = resolveCity(fields[2], city2)).empty()) return error;
+            if (!(error = connectCities(city1, city2)).empty()) return error;
+            if (fields.size() == 4) return runCommand({"set-budget", fields[1], fields[2], fields[3]});
+            return "";
+        }
+        if (command == "set-budget" && fields.size() == 4) {
+            if (!(error = resolveCity(fields[1], city1)).empty()) return error;
+            if (!(error = resolveCity(fields[2], city2)).empty()) return error;
+            double budget;
+            if (!(error = parseBudget(fields[3], budget)).empty()) return error;
+            return assignBudget(city1, city2, budget);
+        }
+        if (command == "rename-city" && fields.size() == 3) {
+            if (!(error = resolveCity(fields[1], city1)).empty()) return error;
+            string name = trim(fields[2]);
+            if (name.empty()) return "City name cannot be empty!";
+            return renameCity(city1, name);
+        }
+        if (command == "set-area" && fields.size() == 3) {
+            if (!(error = resolveCity(fields[1], city1)).empty()) return error;
+            return placeCity(city1, trim(fields[2]));
+        }
+        if (command == "set-location" && fields.size() == 4) {
+            if (!(error = resolveCity(fields[1], city1)).empty()) return error;
+            double latitude = 0.0, longitude = 0.0;
+            if (!(error = parsePosition(fields[2], fields[3], latitude, longitude)).empty()) return error;
+            return setLocation(city1, latitude, longitude);
+        }
+        if ((command == "nearest" && (fields.size() == 2 || fields.size() == 3)) ||
+            (command == "nearest-point" && (fields.size() == 3 || fields.size() == 4))) {
+            double latitude = 0.0, longitude = 0.0;
+            int k = 5;
+            size_t kField = 2;
+            city1 = -1;
+            if (command == "nearest") {
+                if (!(error = resolveCity(fields[1], city1)).empty()) return error;
+                if (!(error = positionOf(city1, latitude, longitude)).empty()) return error;
+            } else {
+                if (!(error = parsePosition(fields[1], fields[2], latitude, longitude)).empty()) return error;
+                kField = 3;
+            }
+            if (fields.size() > kField && !(error = parseNumber(fields[kField], k)).empty()) return error;
+            if (k < 1) return "Ask for at least 1 city!";
+            showNearby(to_string(k) + " nearest cities" + (city1 == -1 ? "" : " to " + cities[city1].name),
+                       nearestCities(latitude, longitude, static_cast<size_t>(k), city1));
+            return "";
+        }
+        if (command == "within" && fields.size() == 3) {
+            if (!(error = resolveCity(fields[1], city1)).empty()) return error;
+            double latitude = 0.0, longitude = 0.0, km;
+            if (!(error = positionOf(city1, latitude, longitude)).empty()) return error;
+            string radius = trim(fields[2]);
+            if (!readDouble(radius, km) || km < 0) return "Distance '" + radius + "' is not a number of km!";
+            showNearby("Cities within " + radius + " km of " + cities[city1].name, citiesWithin(latitude, longitude, km, city1));
+            return "";
+        }
+        if (command == "area-budgets" && (fields.size() == 2 || fields.size() == 3)) {
+            int level = AdminTree::parseLevel(fields[1]);
+            if (level == -1) return "Unknown level '" + trim(fields[1]) + "' (use province, district, sector, cell or village)";
+            return showAreaBudgets(level, fields.size() == 3 ? trim(fields[2]) : "");
+        }
+        if (command == "budget-report" && fields.size() <= 2) {
+            int k = 10;
+            if (fields.size() == 2 && !(error = parseNumber(fields[1], k)).empty()) return error;
+            if (k < 1) return "Ask for at least 1 road in the report!";
+            showBudgetReport(static_cast<size_t>(k));
+            return "";
+        }
+        if (command == "budget-range" && fields.size() == 3) {
+            double low, high;
+            if (!(error = parseBudget(fields[1], low)).empty()) return error;
+            if (!(error = parseBudget(fields[2], high)).empty()) return error;
+            return showBudgetRange(low, high);
+        }
+        if (command == "city-budget" && fields.size() == 2) {
+            if (!(error = resolveCity(fields[1], city1)).empty()) return error;
+            cout << cities[city1].name << " (" << city1 << "): " << fixed << setprecision(2) << ledger.cityBudget(city1)
+                 << " billion RWF on " << network.neighbors(city1).size() << " road(s)\n";
+            return "";
+        }
+        if (command == "delete-city" && fields.size() == 2) {
+            if (!(error = resolveCity(fields[1], city1)).empty()) return error;
+            return deleteCity(city1);
+        }
+        if (command == "delete-road" && fields.size() == 3) {
+            if (!(error = resolveCity(fields[1], city1)).empty()) return error;
+            if (!(error = resolveCity(fields[2], city2)).empty()) return error;
+            return deleteRoad(city1, city2);
+        }
+        if (command == "compact" && fields.size() == 1) {
+            compactIds();
+            return "";
+        }
+        if (command == "prefix" && fields.size() == 2) {
+            vector<int> found = findCitiesByPrefix(trim(fields[1]));
+            if (found.empty()) return "No city name starts with '" + trim(fields[1]) + "'!";
+            for (int index : found) {
+                cout << "Found: Index " << index << ", Name: " << cities[index].name << "\n";
+            }
+            return "";
+        }
+        if ((command == "route" && (fields.size() == 3 || fields.size() == 4)) || (command == "hops" && fields.size() == 3)) {
+            if (!(error = resolveCity(fields[1], city1)).empty()) return error;
+            if (!(error = resolveCity(fields[2], city2)).empty()) return error;
+            return showRoute(city1, city2, command == "route", command == "hops", fields.size() == 4 ? trim(fields[3]) : "auto");
+        }
+        if (command == "connected" && fields.size() == 3) {
+            if (!(error = resolveCity(fields[1], city1)).empty()) return error;
+            if (!(error = resolveCity(fields[2], city2)).empty()) return error;
+            return showConnection(city1, city2);
+        }
+        if (command == "component" && fields.size() == 2) {
+            if (!(error = resolveCity(fields[1], city1)).empty()) return error;
+            refreshConnectivity();
+            cout << cities[city1].name << " is in cluster " << connectivity.find(city1) << " with "
+                 << connectivity.sizeOf(city1) << " cities\n";
+            return "";
+        }
+        if (command == "components" && fields.size() == 1) {
+            cout << "The network has " << componentCount() << " separate cluster(s) of cities\n";
+            return "";
+        }
+        if (command == "plan" && fields.size() <= 2) {
+            return showPlan(fields.size() == 2 ? trim(fields[1]) : "auto");
+        }
+        if (command == "show-cities" && (fields.size() == 1 || fields.size() == 3)) {
+            vector<int> range{0, INT_MAX};
+            for (size_t f = 1; f < fields.size(); ++f) {
+                if (!(error = parseNumber(fields[f], range[f - 1])).empty()) return error;
+            }
+            ScreenBuffer out;
+            renderCities(out, range[0], range[1]);
+            out.flush();
+            return "";
+        }
+        if ((command == "show-roads" || command == "show-budgets") && (fields.size() == 1 || fields.size() == 5)) {
+            Window window{0, nextIndex - 1, 0, nextIndex - 1};
+            int *bounds[] = {&window.rowFrom, &window.rowTo, &window.colFrom, &window.colTo};
+            for (size_t f = 1; f < fields.size(); ++f) {
+                if (!(error = parseNumber(fields[f], *bounds[f - 1])).empty()) return error;
+            }
+            ScreenBuffer out;
+            renderMatrix(out, window, command == "show-budgets");
+            out.flush();
+            return "";
+        }
+        if (command == "road-list" && fields.size() == 1) {
+            displayRoadList();
+            return "";
+        }
+        if (command == "stats" && fields.size() == 1) {
+            displayStats();
+            return "";
+        }
+        if (command == "query" && fields.size() == 2) {
+            if (!(error = resolveCity(fields[1], city1)).empty()) return error;
+            cout << "Found: Index " << city1 << ", Name: " << cities[city1].name << placeNote(city1) << "\n";
+            return "";
+        }
+        return "Unknown command or wrong number of fields: '" + command + "'";
+    }
+
+    // Start a bulk edit: make room for expectedCities more cities in one go and stop
+    // journaling each edit. Call endBulk() and then saveData() when done.
+    void beginBulk(size_t expectedCities) {
+        batchMode = true;
+        cities.reserve(nextIndex + expectedCities);
+        network.resize(nextIndex + static_cast<int>(expectedCities)); // Grow once for the whole batch
+        connectivity.resize(network.size());
+    }
+
+    void endBulk() {
+        batchMode = false;
+        refreshConnectivity(); // Once for every delete in the batch
+    }
+
+    bool hasUnsavedChanges() const { return unsaved; }
+
+    // Batch mode: run a whole script of commands, one per line, like
+    //   add-city,Karongi   add-road,Kigali,Karongi,45   set-budget,1,8,30   query,Karongi
+    // Everything is applied in one go: storage grows once and we save once at the end.
+    void runBatch(istream &in) {
+        auto start = chrono::steady_clock::now();
+        vector<string> lines;
+        string line;
+        size_t newCities = 0;
+        while (getline(in, line)) {
+            if (trim(line).rfind("add-city", 0) == 0) newCities++;
+            lines.push_back(line);
+        }
+        beginBulk(newCities);
+        size_t commands = 0, failed = 0;
+        for (size_t n = 0; n < lines.size(); ++n) {
+            string command = trim(lines[n]);
+            if (command.empty() || command[0] == '#') continue; // Skip blanks and comments
+            commands++;
+            string error = runCommand(splitFields(command));
+            if (!error.empty()) {
+                failed++;
+                cout << "Line " << (n + 1) << ": Error: " << error << "\n";
+            }
+        }
+        endBulk();
+        if (unsaved) saveData(); // One save for the whole batch
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "Batch finished: " << commands << " commands (" << failed << " failed) in "
+             << fixed << setprecision(3) << seconds << " s, "
+             << setprecision(0) << (seconds > 0 ? commands / seconds : 0.0) << " ops/sec\n";
+    }
+
+    // Rough bytes held by the city list and its two name lookups
+    size_t cityBytes() const {
+        auto heapBytes = [](const string &text) { // Short names live inside the string itself
+            return text.capacity() > 15 ? text.capacity() + 1 : 0;
+        };
+        size_t bytes = cities.memoryBytes() + nameIndex.bucket_count() * sizeof(void *);
+        for (const auto &kv : nameIndex) bytes += sizeof(kv) + 2 * sizeof(void *) + heapBytes(kv.first);
+        return bytes + namePrefixes.memoryBytes();
+    }
+
+    // Print the operation timings and memory use, like a health check-up
+    void writeStats(ostream &out) const {
+        auto micros = [](uint64_t ns) { return ns / 1000.0; };
+        out << "\n--- Operation Stats ---\n";
+        out << left << setw(14) << "Operation" << right << setw(10) << "Count" << setw(12) << "Total ms"
+            << setw(12) << "p50 us" << setw(12) << "p99 us" << setw(12) << "Max us" << "\n";
+        for (size_t op = 0; op < metrics.size(); ++op) {
+            const LatencyStats &stats = metrics[op];
+            if (stats.calls() == 0) continue;
+            out << left << setw(14) << OP_NAMES[op] << right << setw(10) << stats.calls()
+                << fixed << setprecision(2) << setw(12) << stats.total() / 1e6
+                << setw(12) << micros(stats.percentile(0.50)) << setw(12) << micros(stats.percentile(0.99))
+                << setw(12) << micros(stats.slowest()) << "\n";
+        }
+        out << "\n--- Memory ---\n";
+        out << setprecision(1);
+        out << "Cities:  " << cities.size() << " cities, ~" << cityBytes() / 1024.0 << " KB (names and lookups included)\n";
+        out << "Roads:   " << network.roadTotal() << " roads, ~" << network.memoryBytes() / 1024.0 << " KB\n";
+        out << "Budgets: ~" << network.budgetBytes() / 1024.0 << " KB (part of the roads above), ledger ~"
+            << ledger.memoryBytes() / 1024.0 << " KB\n";
+        size_t asked, written, coalesced;
+        saver.counts(asked, written, coalesced);
+        if (asked > 0) {
+            out << "Saves:   " << asked << " checkpoints, " << written << " written to disk, " << coalesced
+                << " coalesced (replaced by a newer one before the disk got to them)\n";
+        }
+        if (locator.size() > 0) {
+            out << "Places:  " << locator.size() << " cities with a position, k-d tree ~" << locator.memoryBytes() / 1024.0
+                << " KB" << (locatorStale ? " (rebuilt at the next nearby search)" : "") << "\n";
+        }
+        if (hierarchy.size() > 0) {
+            out << "Routes:  hierarchy with " << hierarchy.arcCount() << " upward roads and shortcuts"
+                << (hierarchyStale ? " (rebuilt at the next route)" : "") << "\n";
+        } else if (hierarchyFailed) {
+            out << "Routes:  no hierarchy, the roads needed too many shortcuts (routes use Dijkstra or A*)\n";
+        }
+    }
+
+    void displayStats() const { writeStats(cout); }
+
+    // Redo the connectivity groups from scratch, one union per road. New roads only
+    // ever merge groups, but if roads can go away this is the way to split them again.
+    void rebuildConnectivity() {
+        connectivityStale = false;
+        connectivity.reset(network.size());
+        for (int i = 0; i < network.size(); ++i) {
+            if (!cities.has(i)) continue;
+            for (const Road &road : network.neighbors(i)) {
+                if (road.to > i && cities.has(road.to)) connectivity.unite(i, road.to);
+            }
+        }
+    }
+
+    // After a delete: regroup now, or once at the end of a batch (a batch deleting
+    // thousands of roads would otherwise redo the whole grouping thousands of times)
+    void regroupAfterDelete() {
+        if (batchMode) connectivityStale = true;
+        else rebuildConnectivity();
+    }
+
+    // Regroup if a batch deleted roads since the last time, before answering from connectivity
+    void refreshConnectivity() {
+        if (connectivityStale) rebuildConnectivity();
+    }
+
+    // Freeze the current network into a read-only snapshot for concurrent readers.
+    // Costs O(cities + roads), so publish one per change, not per query.
+    shared_ptr<const GraphSnapshot> makeSnapshot(uint64_t version) {
+        auto frozen = make_shared<GraphSnapshot>();
+        frozen->version = version;
+        frozen->names.resize(network.size());
+        frozen->component.assign(network.size(), -1);
+        refreshConnectivity();
+        for (const City &city : cities) {
+            frozen->names[city.index] = city.name;
+            frozen->component[city.index] = connectivity.find(city.index);
+            frozen->highestId = max(frozen->highestId, city.index);
+        }
+        frozen->nameIndex = nameIndex;
+        frozen->roads = network.snapshot();
+        frozen->components = componentCount();
+        return frozen;
+    }
+
+    // Number of separate clusters of cities (a city with no roads is its own cluster)
+    size_t componentCount() {
+        refreshConnectivity();
+        return cities.size() - connectivity.mergeCount();
+    }
+
+    // Print whether two cities are linked, and how big their cluster is
+    string showConnection(int city1, int city2) {
+        OpTimer timer(metrics, Op::Connectivity);
+        if (!cities.has(city1) || !cities.has(city2)) {
+            return "One or both cities do not exist!";
+        }
+        refreshConnectivity();
+        if (connectivity.connected(city1, city2)) {
+            cout << cities[city1].name << " and " << cities[city2].name << " are connected (same cluster of "
+                 << connectivity.sizeOf(city1) << " cities)\n";
+        } else {
+            cout << cities[city1].name << " and " << cities[city2].name << " are NOT connected ("
+                 << cities[city1].name << " is in a cluster of " << connectivity.sizeOf(city1) << ", "
+                 << cities[city2].name << " in a cluster of " << connectivity.sizeOf(city2) << ")\n";
+        }
+        return "";
+    }
+
+    // Ask for two cities and say if a chain of roads links them
+    void checkConnection() {
+        int city1 = readInt("Enter first city index: ", 1, nextIndex - 1);
+        int city2 = readInt("Enter second city index: ", 1, nextIndex - 1);
+        string error = showConnection(city1, city2);
+        if (!error.empty()) {
+            cout << "Error: " << error << "\n";
+            return;
+        }
+        cout << "The network has " << componentCount() << " separate cluster(s) of cities\n";
+    }
+
+    // Every road once (smaller ID first), as plain records for the planner
+    vector<PlannedRoad> listRoads() const {
+        vector<PlannedRoad> list;
+        list.reserve(network.roadTotal());
+        for (int i = 0; i < network.size(); ++i) {
+            if (!cities.has(i)) continue;
+            for (const Road &road : network.neighbors(i)) {
+                if (road.to > i && cities.has(road.to)) list.push_back({i, road.to, road.budget});
+            }
+        }
+        return list;
+    }
+
+    // Work out the minimum total budget that keeps every connected city connected.
+    // method is "auto", "kruskal" or "boruvka"
+    string showPlan(const string &method) {
+        OpTimer timer(metrics, Op::Plan);
+        vector<PlannedRoad> roads = listRoads();
+        NetworkPlan plan;
+        if (method == "kruskal") {
+            plan = NetworkPlanner::kruskal(roads, network.size());
+        } else if (method == "boruvka") {
+            plan = NetworkPlanner::boruvka(roads, network.size(), thread::hardware_concurrency());
+        } else if (method == "auto") {
+            plan = NetworkPlanner::plan(roads, network.size());
+        } else {
+            return "Unknown planning method '" + method + "' (use kruskal or boruvka)";
+        }
+        const size_t SHOW = 50; // Don't flood the screen on huge networks
+        double saved = 0.0;
+        for (const PlannedRoad &road : plan.redundant) saved += road.budget;
+        cout << "\n--- Minimum Budget Network Plan ---\n";
+        cout << "Roads to keep (" << plan.kept.size() << "):\n";
+        for (size_t i = 0; i < plan.kept.size() && i < SHOW; ++i) {
+            const PlannedRoad &road = plan.kept[i];
+            cout << "  " << cities[road.a].name << "-" << cities[road.b].name << " | "
+                 << fixed << setprecision(2) << road.budget << "\n";
+        }
+        if (plan.kept.size() > SHOW) cout << "  ... and " << (plan.kept.size() - SHOW) << " more\n";
+        cout << "Redundant roads (" << plan.redundant.size() << "):\n";
+        for (size_t i = 0; i < plan.redundant.size() && i < SHOW; ++i) {
+            const PlannedRoad &road = plan.redundant[i];
+            cout << "  " << cities[road.a].name << "-" << cities[road.b].name << " | "
+                 << fixed << setprecision(2) << road.budget << "\n";
+        }
+        if (plan.redundant.size() > SHOW) cout << "  ... and " << (plan.redundant.size() - SHOW) << " more\n";
+        cout << "Minimum total budget: " << fixed << setprecision(2) << plan.totalCost << " billion RWF"
+             << " (skipping the redundant roads saves " << saved << " billion RWF)\n";
+        cout << "Separate clusters after the plan: " << componentCount() << "\n";
+        return "";
+    }
+
+    // "Kigali -> Muhanga -> Huye" for a list of city indexes
+    string describeRoute(const vector<int> &path) {
+        string text;
+        for (size_t i = 0; i < path.size(); ++i) {
+            if (i > 0) text += " -> ";
+            text += cities[path[i]].name;
+        }
+        return text;
+    }
+
+    // Bring the contraction hierarchy up to date after road edits. A batch of edits
+    // costs one rebuild, done when the next route is asked for. False if the build
+    // gave up because this network doesn't suit a hierarchy.
+    bool refreshHierarchy() {
+        if (!hierarchyStale && (hierarchyFailed || hierarchy.size() == network.size())) return !hierarchyFailed;
+        OpTimer timer(metrics, Op::Hierarchy);
+        hierarchyFailed = !hierarchy.build(network.snapshot());
+        hierarchyStale = false;
+        return !hierarchyFailed;
+    }
+
+    // Work out kmRate for A*: no road costs less per straight-line km than this, so
+    // kmRate x (km left to the target) never overestimates the money still needed.
+    // A* is off (-1) while any city with a road has no position, since nothing then
+    // bounds what its roads cost. Roads with no budget yet make the rate 0 (plain Dijkstra).
+    void refreshKmRate() {
+        if (!kmRateStale) {
+            // Cities added since have no position and no roads yet, so kmRate still holds;
+            // they just need a slot, or ballOf[new ID] would read past the end
+            ballOf.resize(network.size(), {0.0, 0.0, 0.0});
+            return;
+        }
+        kmRateStale = false;
+        kmRate = numeric_limits<double>::infinity();
+        ballOf.assign(network.size(), {0.0, 0.0, 0.0});
+        for (const City &city : cities) {
+            if (city.located()) ballOf[city.index] = toBall(city.latitude, city.longitude);
+        }
+        for (const City &city : cities) {
+            for (const Road &road : network.neighbors(city.index)) {
+                if (road.to < city.index || !cities.has(road.to)) continue; // Each road once
+                const City &other = cities.at(road.to);
+                if (!city.located() || !other.located()) {
+                    kmRate = -1;
+                    return;
+                }
+                double km = distanceKm(city.latitude, city.longitude, other.latitude, other.longitude);
+                if (km > 0) kmRate = min(kmRate, road.budget / km);
+            }
+        }
+        if (kmRate == numeric_limits<double>::infinity()) kmRate = 0.0;
+        kmRate *= 1.0 - 1e-9; // A hair lower, so rounding never makes the guess too high
+    }
+
+    // Can routes use A* right now (every road end has a position)?
+    bool canGuessRoutes() {
+        refreshKmRate();
+        return kmRate >= 0;
+    }
+
+    // Cheapest route from one city to another, by "dijkstra" (cached search trees),
+    // "hierarchy" (contraction hierarchy), "astar" (Dijkstra steered by straight-line
+    // distance, when cities have positions) or "auto" (hierarchy on big networks,
+    // otherwise A* if it can be used). If the hierarchy can't be built for this network
+    // the route falls back to Dijkstra, and "auto" only tries it again after road edits.
+    // Returns the cost, infinity if there is no route; path gets both ends.
+    double cheapestRoute(int from, int to, vector<int> &path, const string &method = "auto") {
+        bool wantHierarchy = method == "hierarchy" ||
+                             (method == "auto" && cities.size() >= HIERARCHY_FROM && (!hierarchyFailed || hierarchyStale));
+        if (wantHierarchy && refreshHierarchy()) return hierarchy.route(from, to, path);
+        if ((method == "astar" || method == "auto") && canGuessRoutes()) {
+            // Straight line through the Earth is never longer than over it, so this stays a lower bound
+            const array<double, 3> target = ballOf[to];
+            double perChord = kmRate * EARTH_RADIUS_KM;
+            return routes.guidedRoute(network.snapshot(), from, to, [&](int city) {
+                return perChord * chordBetween(ballOf[city], target);
+            }, path);
+        }
+        const RouteTree &tree = routes.treeFrom(network, from);
+        path = RouteEngine::pathTo(tree, to);
+        return tree.cost[to];
+    }
+
+    // Print the cheapest route and the fewest-roads route between two cities
+    string showRoute(int from, int to, bool cheapest, bool fewest, const string &method = "auto") {
+        OpTimer timer(metrics, Op::Route);
+        if (!cities.has(from) || !cities.has(to)) {
+            return "One or both cities do not exist!";
+        }
+        if (method != "auto" && method != "dijkstra" && method != "hierarchy" && method != "astar") {
+            return "Unknown route method '" + method + "' (use dijkstra, hierarchy or astar)";
+        }
+        if (method == "astar" && cheapest && !canGuessRoutes()) {
+            cout << "Note: Some cities with roads have no position yet, so this route uses plain Dijkstra\n";
+        }
+        if (cheapest) {
+            vector<int> path;
+            double cost = cheapestRoute(from, to, path, method);
+            if (method == "hierarchy" && hierarchyFailed) {
+                cout << "Note: These roads cross too much for shortcuts to help, so this route uses plain Dijkstra\n";
+            }
+            if (path.empty()) return "No route between " + cities[from].name + " and " + cities[to].name + "!";
+            cout << "Cheapest route: " << describeRoute(path) << " (" << (path.size() - 1) << (path.size() == 2 ? " road, " : " roads, ")
+                 << fixed << setprecision(2) << cost << " billion RWF)\n";
+        }
+        if (fewest) {
+            vector<int> path = RouteEngine::fewestRoads(network.snapshot(), from, to);
+            if (path.empty()) return "No route between " + cities[from].name + " and " + cities[to].name + "!";
+            cout << "Fewest roads: " << describeRoute(path) << " (" << (path.size() - 1) << (path.size() == 2 ? " road)\n" : " roads)\n");
+        }
+        return "";
+    }
+
+    // Ask for two cities and show the cheapest way to get from one to the other
+    void findRoute() {
+        int from = readInt("Enter starting city index: ", 1, nextIndex - 1);
+        int to = readInt("Enter destination city index: ", 1, nextIndex - 1);
+        string error = showRoute(from, to, true, true);
+        if (!error.empty()) cout << "Error: " << error << "\n";
+    }
+
+    // Find cities by the start of their name, like "Mu" -> Muhanga, Musanze
+    void searchByPrefix() {
+        string prefix = readString("Enter the start of a city name: ");
+        vector<int> found = findCitiesByPrefix(prefix);
+        if (found.empty()) {
+            cout << "Error: No city name starts with '" << prefix << "'!\n";
+            return;
+        }
+        for (int index : found) {
+            cout << "Found: Index " << index << ", Name: " << cities[index].name << "\n";
+        }
+    }
+
+    void searchByIndex() {
+        int index = readInt("Enter city index to search: ", 1, nextIndex - 1); // Ask for the city’s ID
+        if (cities.has(index)) {
+            cout << "Found: Index " << index << ", Name: " << cities[index].name << placeNote(index) << "\n"; // Sweet, we found it!
+        } else {
+            cout << "Error: City with index " << index << " not found!\n"; // Oops, no city with that ID!
+        }
+    }
+
+    // All city IDs from..to (inclusive) in order, skipping gaps
+    vector<int> sortedCities(int from = 0, int to = INT_MAX) const {
+        vector<int> list;
+        // Cities sit in ID order already, so just walk the slots in the range
+        to = min(to, cities.slotCount() - 1);
+        for (int i = max(from, 0); i <= to; ++i) {
+            if (cities.has(i)) list.push_back(i);
+        }
+        return list;
+    }
+
+    // Which part of a big matrix to show (city IDs, inclusive)
+    struct Window {
+        int rowFrom, rowTo, colFrom, colTo;
+    };
+
+    static const int SCREEN_CITIES = 20; // Matrices wider than this get shown a window at a time
+    static const int SCREEN_ROWS = 200; // City lists longer than this get shown a page at a time
+
+    // Small network? Show it all. Big one? Ask which rows/columns to show.
+    Window askWindow() {
+        Window window{1, nextIndex - 1, 1, nextIndex - 1};
+        if (static_cast<int>(cities.size()) <= SCREEN_CITIES) return window;
+        cout << "There are " << cities.size() << " cities, so let's show a window of the matrix (IDs 1 to "
+             << (nextIndex - 1) << ").\n";
+        window.rowFrom = readInt("Rows from city index: ", 1, nextIndex - 1);
+        window.rowTo = readInt("Rows to city index: ", window.rowFrom, nextIndex - 1);
+        window.colFrom = readInt("Columns from city index: ", 1, nextIndex - 1);
+        window.colTo = readInt("Columns to city index: ", window.colFrom, nextIndex - 1);
+        return window;
+    }
+
+    // The city table, sorted by index
+    void renderCities(ScreenBuffer &out, int from, int to) const {
+        OpTimer timer(metrics, Op::Display);
+        out.add("\n--- Cities ---\n");
+        out.add("Index | City Name\n");
+        out.add("------|----------\n");
+        for (int i : sortedCities(from, to)) {
+            out.number(i, 5).add(" | ").add(cities.at(i).name).add("\n"); // Neat table of cities
+        }
+    }
+
+    // One matrix (roads as 1/0, or budgets) for the cities inside the window.
+    // Each row is filled from that city's road list, so it costs O(columns + roads).
+    void renderMatrix(ScreenBuffer &out, const Window &window, bool showBudgets) const {
+        OpTimer timer(metrics, Op::Display);
+        int width = showBudgets ? 8 : 5;
+        out.add(showBudgets ? "\nBudget Adjacency Matrix (billions RWF):\n"
+                            : "\nRoad Adjacency Matrix (1 = road exists, 0 = no road):\n");
+        vector<int> rows = sortedCities(window.rowFrom, window.rowTo);
+        vector<int> columns = sortedCities(window.colFrom, window.colTo);
+        vector<int> columnOf(network.size(), -1); // City ID -> column position
+        out.add("   ");
+        for (size_t c = 0; c < columns.size(); ++c) {
+            columnOf[columns[c]] = static_cast<int>(c);
+            out.number(columns[c], width); // City IDs as headers
+        }
+        out.add("\n");
+        vector<double> cells(columns.size());
+        vector<char> hasRoad(columns.size());
+        for (int i : rows) {
+            fill(cells.begin(), cells.end(), 0.0);
+            fill(hasRoad.begin(), hasRoad.end(), 0);
+            for (const Road &road : network.neighbors(i)) {
+                int c = columnOf[road.to];
+                if (c != -1) {
+                    hasRoad[c] = 1;
+                    cells[c] = road.budget;
+                }
+            }
+            out.number(i, 2).add(":");
+            for (size_t c = 0; c < columns.size(); ++c) {
+                if (showBudgets) {
+                    out.money(cells[c], width);
+                } else {
+                    out.number(hasRoad[c], width); // 1 or 0 for roads
+                }
+            }
+            out.add("\n");
+        }
+    }
+
+    // Every road once, as "Kigali (1) - Muhanga (3) | 28.60", sorted by city index.
+    // Costs O(roads), no matter how many cities there are.
+    void renderRoadList(ScreenBuffer &out) const {
+        OpTimer timer(metrics, Op::Display);
+        out.add("\n--- Roads ---\n");
+        out.add("Road | Budget (billions RWF)\n");
+        out.add("-----|----------------------\n");
+        vector<pair<int, double>> ends;
+        for (int i : sortedCities()) {
+            ends.clear();
+            for (const Road &road : network.neighbors(i)) {
+                if (road.to > i && cities.has(road.to)) ends.emplace_back(road.to, road.budget);
+            }
+            sort(ends.begin(), ends.end());
+            for (const auto &end : ends) {
+                out.add(cities.at(i).name).add(" (").number(i).add(") - ")
+                   .add(cities.at(end.first).name).add(" (").number(end.first).add(") | ")
+                   .money(end.second).add("\n"); // List roads and budgets
+            }
+        }
+        out.add("Total roads: ").number(static_cast<long long>(network.roadTotal())).add("\n");
+    }
+
+    // Show all cities, like a tour guide listing hot spots (a page at a time if there are lots)
+    void displayCities() {
+        int from = 1, to = nextIndex - 1;
+        if (static_cast<int>(cities.size()) > SCREEN_ROWS) {
+            cout << "There are " << cities.size() << " cities, pick a range of IDs to show (1 to " << (nextIndex - 1) << ").\n";
+            from = readInt("From city index: ", 1, nextIndex - 1);
+            to = readInt("To city index: ", from, nextIndex - 1);
+        }
+        ScreenBuffer out;
+        renderCities(out, from, to);
+        out.flush();
+    }
+
+    // Show all roads, like mapping out Rwanda’s highways
+    void displayRoads() {
+        Window window = askWindow();
+        ScreenBuffer out;
+        renderCities(out, min(window.rowFrom, window.colFrom), max(window.rowTo, window.colTo)); // First, the cities in view
+        renderMatrix(out, window, false); // Show a grid of which cities are connected
+        out.flush();
+    }
+
+    // Show every road with its budget as a plain list, great for big networks
+    void displayRoadList() {
+        ScreenBuffer out;
+        renderRoadList(out);
+        out.flush();
+    }
+
+    // Show everything, like a full Rwanda road trip overview!
+    void displayData() {
+        Window window = askWindow();
+        ScreenBuffer out;
+        out.add("\n--- Recorded Data ---\n");
+        renderCities(out, min(window.rowFrom, window.colFrom), max(window.rowTo, window.colTo)); // List the cities
+        renderMatrix(out, window, false); // Show road grid
+        renderMatrix(out, window, true); // Show budget grid
+        out.flush();
+    }
+
+    // Checkpoint: copy what the files need (quick, on this thread) and hand it to the
+    // background saver, which writes the files to temp copies, pushes them to disk and
+    // swaps them in while we carry on. The journal's records are set aside until that
+    // write is done, so a crash leaves either the old network.bin plus the set-aside
+    // journal, or the new network.bin (see BackgroundSaver::writeAll).
+    void saveData() {
+        OpTimer timer(metrics, Op::Save);
+        reportSaveFailure();
+        auto job = make_shared<SaveJob>();
+        job->cities.reserve(cities.size());
+        for (const City &city : cities) {
+            job->cities.push_back({city.index, city.name, areas.pathOf(city.area), city.latitude, city.longitude});
+        }
+        job->roads = listRoads();
+        job->nextIndex = nextIndex;
+        saver.submit(move(job));
+        unsaved = false;
+    }
+
+    // Flush barrier: wait until every checkpoint handed over so far is on disk.
+    // False if one of them didn't make it.
+    bool flushSaves() {
+        saver.flush();
+        return !reportSaveFailure();
+    }
+
+    // Tell the user if a background write didn't make it; true if one failed
+    bool reportSaveFailure() {
+        if (!saver.takeFailure()) return false;
+        cout << "Error: Could not save data files, changes are kept in the journal.\n";
+        return true;
+    }
+
+    // Open network.bin straight from memory, no text parsing, and say which checkpoint
+    // it holds. False (and nothing changed) if it's missing, from another version, or
+    // fails its checksum.
+    bool loadSnapshot(uint64_t &checkpoint) {
+        MappedFile file("network.bin");
+        if (!file.data()) return false;
+        SnapshotHeader header;
+        if (file.size() < sizeof(header)) return false;
+        memcpy(&header, file.data(), sizeof(header));
+        if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != SNAPSHOT_VERSION || header.headerSize != sizeof(SnapshotHeader)) {
+            cout << "Warning: network.bin is from a different version, loading the text files instead\n";
+            return false;
+        }
+        const char *body = file.data() + sizeof(header);
+        size_t bodySize = file.size() - sizeof(header);
+        // Check the sizes add up before trusting any of them
+        if (header.cityCount > bodySize / sizeof(SnapshotCity) || header.stringBytes > bodySize ||
+            header.roadCount > bodySize / sizeof(SnapshotRoad)) {
+            cout << "Warning: network.bin is damaged, loading the text files instead\n";
+            return false;
+        }
+        size_t tableBytes = header.cityCount * sizeof(SnapshotCity);
+        size_t roadsAt = alignTo8(tableBytes + header.stringBytes);
+        if (roadsAt + header.roadCount * sizeof(SnapshotRoad) != bodySize ||
+            checksum64(body, bodySize) != header.checksum) {
+            cout << "Warning: network.bin is damaged, loading the text files instead\n";
+            return false;
+        }
+        const char *pool = body + tableBytes;
+        const char *roadBytes = body + roadsAt;
+        int highest = 0;
+        for (uint64_t i = 0; i < header.cityCount; ++i) {
+            SnapshotCity city;
+            memcpy(&city, body + i * sizeof(SnapshotCity), sizeof(city));
+            if (city.index < 0 || city.nameOffset + city.nameLength + city.areaLength > header.stringBytes) return false;
+            highest = max(highest, static_cast<int>(city.index));
+        }
+        // All good, now fill in our structures (the file has every city, starting ones included)
+        clearCities();
+        nextIndex = max({nextIndex, static_cast<int>(header.nextIndex), highest + 1});
+        cities.reserve(header.cityCount);
+        for (uint64_t i = 0; i < header.cityCount; ++i) {
+            SnapshotCity city;
+            memcpy(&city, body + i * sizeof(SnapshotCity), sizeof(city));
+            setCity(city.index, string(pool + city.nameOffset, city.nameLength));
+            if (city.areaLength > 0) {
+                cities[city.index].area = areas.place(string(pool + city.nameOffset + city.nameLength, city.areaLength));
+            }
+            if (validPosition(city.latitude, city.longitude)) { // NAN fails this too
+                cities[city.index].latitude = city.latitude;
+                cities[city.index].longitude = city.longitude;
+            }
+        }
+        resizeRoadStorage();
+        for (uint64_t i = 0; i < header.roadCount; ++i) {
+            SnapshotRoad road;
+            memcpy(&road, roadBytes + i * sizeof(SnapshotRoad), sizeof(road));
+            if (!cities.has(road.a) || !cities.has(road.b)) continue;
+            if (!network.addRoad(road.a, road.b, road.budget)) network.setBudget(road.a, road.b, road.budget);
+        }
+        checkpoint = header.checkpoint;
+        return true;
+    }
+
+    // Load our saved map, like opening that drawer: network.bin if it's readable
+    // (it's the one file a checkpoint is committed by, so the text files next to it
+    // may be half a save ahead and are ignored), otherwise the text files, then
+    // whatever the journal adds
+    void loadData() {
+        OpTimer timer(metrics, Op::Load);
+        uint64_t saved = 0; // The checkpoint the loaded files hold
+        if (loadSnapshot(saved)) {
+            unsaved = false;
+        } else {
+            saved = loadTextFiles();
+            unsaved = true; // Came from text (or nothing): write a fresh snapshot at the next checkpoint
+        }
+        // Redo anything that happened after the last checkpoint that made it to disk
+        uint64_t newest = 0;
+        if (journal.replay([&](const vector<string> &fields) { return applyRecord(fields); }, saved, newest) > 0) {
+            unsaved = true;
+        }
+        saver.startNumberingAfter(max(saved, newest));
+        rebuildConnectivity(); // One pass over all roads instead of one union per loaded road
+        ledger.rebuild(network); // Same for the budget totals
+    }
+
+    // Read cities.txt and roads.txt (the import/export format). The files are mapped
+    // into memory and parsed in place on all cores; bad lines are reported by number.
+    // Returns the checkpoint they hold. If a save was cut off between the two files
+    // they disagree, and we go with the older one: replaying its journal records on
+    // top of the newer file is harmless.
+    uint64_t loadTextFiles() {
+        uint64_t olderSave = 0; // Files without a number fall back to checkpoint.txt, where older versions kept it
+        ifstream("checkpoint.txt") >> olderSave;
+        uint64_t citySave = olderSave, roadSave = olderSave;
+        // Load cities
+        {
+            MappedFile cityFile("cities.txt");
+            if (uint64_t number = checkpointOf(cityFile.data(), cityFile.size())) citySave = number;
+            // Saved files list every city still around, so the starting ones only count
+            // if they're in there too (they may have been deleted)
+            if (filesystem::exists("cities.txt")) clearCities();
+            auto parsed = parseLines<CityRow>(cityFile.data(), cityFile.size(), parseCityRow);
+            for (const auto &bad : parsed.bad) {
+                cout << "Error parsing city (line " << bad.first << "): " << bad.second << "\n"; // Oops, bad data!
+            }
+            cities.reserve(cities.size() + parsed.rows.size());
+            for (const CityRow &row : parsed.rows) {
+                setCity(row.index, string(row.name)); // Add to our list
+                string area = trim(string(row.area));
+                if (!area.empty()) cities[row.index].area = areas.place(area);
+                cities[row.index].latitude = row.latitude;
+                cities[row.index].longitude = row.longitude;
+                nextIndex = max(nextIndex, row.index + 1); // Update next ID
+            }
+        }
+        resizeRoadStorage(); // Get our road lists ready
+        // Load roads
+        MappedFile roadFile("roads.txt");
+        if (uint64_t number = checkpointOf(roadFile.data(), roadFile.size())) roadSave = number;
+        if (citySave != roadSave) {
+            cout << "Warning: cities.txt and roads.txt are from different saves, the journal will fill in the gap\n";
+        }
+        auto parsed = parseLines<RoadRow>(roadFile.data(), roadFile.size(), parseRoadRow);
+        for (const auto &bad : parsed.bad) {
+            cout << "Error parsing road (line " << bad.first << "): " << bad.second << "\n"; // Bad road data!
+        }
+        for (const RoadRow &row : parsed.rows) {
+            if (cities.has(row.city1) && cities.has(row.city2)) {
+                if (!network.addRoad(row.city1, row.city2, row.budget)) { // Set road
+                    network.setBudget(row.city1, row.city2, row.budget); // Already there, just update the budget
+                }
+            }
+        }
+        return min(citySave, roadSave);
+    }
+
+    // Show a friendly guide, like a tour guide for our app
+    void displayHelp() {
+        cout << "\n=== Welcome to the Rwanda Road Network Manager! ===\n";
+        cout << "This app helps you keep track of Rwanda’s awesome cities and the roads connecting them, like a super cool map for planning!\n";
+        cout << "\nWhat Can You Do?\n";
+        cout << "- Add Cities: Pop new cities onto the map, like adding a new favorite spot.\n";
+        cout << "- Connect Cities: Build roads between cities, like linking Kigali to Huye.\n";
+        cout << "- Set Budgets: Plan how much cash (in billions of RWF) to spend on roads.\n";
+        cout << "- Save Everything: Your work is saved to files so you can pick up later.\n";
+        cout << "- Auto IDs: Cities get numbered automatically (1, 2, 3...), no stress!\n";
+
+        cout << "\nMenu Options (Pick a Number!):\n";
+        cout << "1. Add new city(ies): Add one or more new cities to the map.\n";
+        cout << "2. Add roads between cities: Connect two cities with a road.\n";
+        cout << "3. Add the budget for roads: Set money for a road, like 28.6 billion RWF.\n";
+        cout << "4. Edit city: Change a city’s name, like renaming Huye to something else.\n";
+        cout << "5. Search for a city using its index: Look up a city by its ID number.\n";
+        cout << "6. Display cities: See all cities and their IDs, sorted by ID (a page at a time for big maps).\n";
+        cout << "7. Display roads: See the cities and a grid of which ones are connected.\n";
+        cout << "8. Display recorded data: See everything—cities, roads, and budgets.\n";
+        cout << "   (With more than " << SCREEN_CITIES << " cities, 7 and 8 ask which rows and columns to show.)\n";
+        cout << "9. Search for a city by name: Look up a city by its exact name.\n";
+        cout << "10. Find cities by name start: Type \"Mu\" to get Muhanga and Musanze.\n";
+        cout << "11. Find cheapest route: The least-budget way between two cities, plus the one with fewest roads.\n";
+        cout << "12. Check connection: Are two cities linked by any chain of roads? Also counts the clusters.\n";
+        cout << "13. Plan minimum budget network: The cheapest set of roads that still connects every city, and which roads are extra.\n";
+        cout << "14. Display road list: Every road and its budget as a simple list, quick even for huge maps.\n";
+        cout << "15. Delete a city: Take a city off the map, along with all its roads.\n";
+        cout << "16. Delete a road: Close the road between two cities.\n";
+        cout << "17. Compact city IDs: Renumber cities 1, 2, 3... to close the gaps left by deleted ones.\n";
+        cout << "18. Place a city in an area: Say which province/district/sector/cell/village it's in, like Southern/Huye.\n";
+        cout << "19. Road budgets by area: Total road money per province, district, etc. (inside vs. crossing the border).\n";
+        cout << "20. Budget report: National total, the priciest roads, the cities with the most money, and roads in a budget range.\n";
+        cout << "21. Set a city's location: Its latitude and longitude, like -1.9441, 30.0619 for Kigali.\n";
+        cout << "22. Nearby cities: The closest cities to one city, and everything within some km of it.\n";
+        cout << "23. Stats: How many times each action ran, how long it took (p50/p99), and memory used.\n";
+        cout << "24. Help: Show this friendly guide.\n";
+        cout << "25. Exit: Save your work and head out.\n";
+
+        cout << "\nTips to Rock This App:\n";
+        cout << "- City IDs are given automatically (1 for Kigali, 2 for Huye, etc.).\n";
+        cout << "- On maps with " << HIERARCHY_FROM << "+ cities, routes use shortcuts worked out after your edits (a short pause the first time; skipped if the roads cross too much for them to help).\n";
+        cout << "- Once every city with a road has a location, routes are steered by straight-line distance (A*), which is quicker.\n";
+        cout << "- A deleted city's ID goes to the next new city. Compacting renumbers everyone, so check id_map.txt.\n";
+        cout << "- Budgets are in billions of RWF, so type a number like 28 for 28 billion.\n";
+        cout << "- Don’t use commas in city names—they mess with our files!\n";
+        cout << "- Everything saves automatically to files, so no worries about losing work.\n";
+
+        cout << "\nWhere’s the Data Kept?\n";
+        cout << "- cities.txt: Lists all cities with their IDs (and area and location, if you set them).\n";
+        cout << "- roads.txt: Shows which cities are connected and their budgets.\n";
+        cout << "- network.bin: A fast binary copy of both, used at startup. Edited the .txt files by hand? Delete network.bin so they get loaded.\n";
+        cout << "- id_map.txt: After compacting, each city's old ID and its new one.\n";
+        cout << "- journal.txt: Quick notes of your latest changes, folded into the files above every so often.\n";
+        cout << "- journal.txt.old: Notes waiting for a save to reach the disk.\n";
+        cout << "  Saves happen in the background; quick bursts of changes are written once.\n";
+
+        cout << "\nBatch Mode (for loading lots of data fast):\n";
+        cout << "- Run: main --batch commands.txt (or main --batch - to read from the keyboard/pipe).\n";
+        cout << "- One command per line, fields split by commas. Cities can be an index or a name:\n";
+        cout << "    add-city,Karongi\n";
+        cout << "    add-road,Kigali,Karongi        (optionally add ,budget at the end)\n";
+        cout << "    set-budget,1,8,45.5\n";
+        cout << "    rename-city,8,Karongi Town\n";
+        cout << "    delete-road,Kigali,Karongi       (also delete-city,Karongi and compact)\n";
+        cout << "    query,Karongi\n";
+        cout << "    prefix,Mu\n";
+        cout << "    route,Rusizi,Kigali              (cheapest by budget; hops,A,B for fewest roads)\n";
+        cout << "    route,Rusizi,Kigali,hierarchy    (or ,dijkstra or ,astar: pick how; big maps use the hierarchy anyway)\n";
+        cout << "    set-area,Huye,Southern/Huye      (province/district/sector/cell/village, as deep as you know)\n";
+        cout << "    set-location,Huye,-2.5967,29.7394 (latitude, longitude in degrees)\n";
+        cout << "    nearest,Huye,5                   (also nearest-point,-2.0,29.8,5 and within,Huye,30 for km)\n";
+        cout << "    area-budgets,district            (or area-budgets,sector,Southern/Huye for one district's sectors)\n";
+        cout << "    budget-report,10                 (also budget-range,20,60 and city-budget,Kigali)\n";
+        cout << "    connected,Rubavu,Rusizi          (also component,A and components)\n";
+        cout << "    plan                             (or plan,kruskal / plan,boruvka to pick the method)\n";
+        cout << "    show-roads,1,20,1,20             (rows 1-20, columns 1-20 by ID; also show-budgets, show-cities,1,50, road-list)\n";
+        cout << "    stats\n";
+        cout << "- Lines starting with # are comments. Everything is saved once at the end.\n";
+        cout << "- Add --stats-file stats.txt (with or without --batch) to save the stats when the app closes.\n";
+        cout << "\nServer Mode (many planners asking questions at once):\n";
+        cout << "- Run: main --serve 7070 [--threads 8], then connect to 127.0.0.1:7070 (e.g. nc 127.0.0.1 7070).\n";
+        cout << "- Send one request per line: lookup,NAME  route,A,B  connected,A,B  components  info\n";
+        cout << "  plus the batch edits add-city, add-road, set-budget, rename-city, delete-city and delete-road. Answers start with OK or ERR.\n";
+        cout << "- Questions never wait for edits: they read a frozen copy that each edit replaces.\n";
+        cout << "- Send quit to hang up, or shutdown to stop the server (changes are saved).\n";
+    }
+};
+
+#endif // CITY_GRAPH_H
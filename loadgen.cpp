@@ -0,0 +1,186 @@
+// Load generator for server mode: many clients firing queries at once, to see how
+// many queries per second the server keeps up with (and how slow the slow ones are).
+//
+// Build: g++ -std=c++17 -O2 -pthread loadgen.cpp -o loadgen
+// Run:   ./main --serve 7070 &   then   ./loadgen [--port 7070] [--threads 8] [--seconds 10]
+//                                                [--mix 80,15,5] [--writes 0]
+// --mix is the percent of lookup,route,connected queries; --writes N makes N of the
+// threads edit roads instead (add one, set its budget, delete it again), to check
+// readers don't slow down during edits.
+#include "city_graph.h" // For splitFields, trim and the latency histogram
+#include <random> // Random cities to ask about
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+#ifndef _WIN32
+// One connection to the server that sends a line and reads the answer line
+class Connection {
+private:
+    int socketFd = -1;
+    string pending; // Bytes received after the last answer
+
+public:
+    bool open(int port) {
+        socketFd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+        return socketFd >= 0 && connect(socketFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0;
+    }
+
+    ~Connection() {
+        if (socketFd >= 0) close(socketFd);
+    }
+
+    // Send one request and wait for its answer; false if the server went away
+    bool ask(const string &request, string &answer) {
+        string line = request + "\n";
+        if (send(socketFd, line.data(), line.size(), 0) != static_cast<ssize_t>(line.size())) return false;
+        size_t newline;
+        char chunk[4096];
+        while ((newline = pending.find('\n')) == string::npos) {
+            ssize_t n = recv(socketFd, chunk, sizeof(chunk), 0);
+            if (n <= 0) return false;
+            pending.append(chunk, static_cast<size_t>(n));
+        }
+        answer = pending.substr(0, newline);
+        pending.erase(0, newline + 1);
+        return true;
+    }
+};
+
+// "p50 0.08 ms, p99 0.41 ms, max 3.20 ms"
+void printLatency(const string &label, const LatencyStats &stats) {
+    cout << "  " << label << ": p50 " << setprecision(3) << stats.percentile(0.50) / 1e6 << " ms, p99 "
+         << stats.percentile(0.99) / 1e6 << " ms, max " << stats.slowest() / 1e6 << " ms\n";
+}
+
+int main(int argc, char *argv[]) {
+    int port = 7070, seconds = 10, writers = 0;
+    unsigned threads = max(1u, thread::hardware_concurrency());
+    int mix[3] = {80, 15, 5}; // lookup, route, connected
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string option = argv[i], value = argv[i + 1];
+        if (option == "--port") {
+            port = stoi(value);
+        } else if (option == "--threads") {
+            threads = static_cast<unsigned>(max(1, stoi(value)));
+        } else if (option == "--seconds") {
+            seconds = max(1, stoi(value));
+        } else if (option == "--writes") {
+            writers = max(0, stoi(value));
+        } else if (option == "--mix") {
+            vector<string> parts = splitFields(value);
+            if (parts.size() != 3) {
+                cout << "--mix needs three percentages, like 80,15,5\n";
+                return 1;
+            }
+            for (int k = 0; k < 3; ++k) mix[k] = stoi(parts[k]);
+        } else {
+            cout << "Unknown option " << option << "\n";
+            return 1;
+        }
+    }
+
+    // Ask the server how big the network is, so we know which IDs to pick from.
+    // Hang up right after: each open connection keeps one server worker busy.
+    string answer;
+    {
+        Connection probe;
+        if (!probe.open(port) || !probe.ask("info", answer) || answer.rfind("OK ", 0) != 0) {
+            cout << "Error: No server answering on 127.0.0.1:" << port << "\n";
+            return 1;
+        }
+    }
+    vector<string> info = splitFields(answer.substr(3)); // version, cities, roads, highest ID
+    int highest = stoi(info[3]);
+    cout << "Server has " << info[1] << " cities and " << info[2] << " roads; running " << threads
+         << " clients (" << writers << " writing) for " << seconds << " s\n";
+
+    atomic<bool> running{true};
+    atomic<size_t> reads{0}, writes{0}, rejected{0}, errors{0};
+    LatencyStats readLatency, writeLatency;
+    vector<thread> clients;
+    for (unsigned t = 0; t < threads; ++t) {
+        clients.emplace_back([&, t] {
+            Connection connection;
+            if (!connection.open(port)) {
+                ++errors;
+                return;
+            }
+            mt19937 random(1234 + t);
+            uniform_int_distribution<int> city(1, max(1, highest)), percent(0, 99); // IDs start at 1
+            bool writer = static_cast<int>(t) < writers;
+            string request, reply;
+            // Writers work on one pair of cities at a time, so their edits hit a real road:
+            // add it, set its budget, then delete it again if we were the ones who added it
+            int step = 0;
+            bool added = false;
+            string edgeA, edgeB;
+            while (running) {
+                int pick = percent(random);
+                string a = to_string(city(random)), b = to_string(city(random));
+                if (writer) {
+                    if (step == 0) {
+                        edgeA = a;
+                        edgeB = b;
+                        request = "add-road," + a + "," + b + "," + to_string(percent(random) + 1);
+                    } else if (step == 1) {
+                        request = "set-budget," + edgeA + "," + edgeB + "," + to_string(percent(random) + 1);
+                    } else {
+                        request = "delete-road," + edgeA + "," + edgeB;
+                    }
+                } else if (pick < mix[0]) {
+                    request = "lookup," + a;
+                } else if (pick < mix[0] + mix[1]) {
+                    request = "route," + a + "," + b;
+                } else {
+                    request = "connected," + a + "," + b;
+                }
+                auto start = chrono::steady_clock::now();
+                if (!connection.ask(request, reply)) {
+                    ++errors;
+                    return;
+                }
+                auto nanos = static_cast<uint64_t>(
+                    chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count());
+                (writer ? writeLatency : readLatency).record(nanos);
+                if (!writer) {
+                    ++reads;
+                    continue;
+                }
+                bool ok = reply.rfind("OK ", 0) == 0;
+                ++(ok ? writes : rejected);
+                if (step == 0) added = ok;
+                step = (step == 1 && !added) ? 0 : (step + 1) % 3; // Leave roads we didn't add alone
+            }
+        });
+    }
+    this_thread::sleep_for(chrono::seconds(seconds));
+    running = false;
+    for (thread &client : clients) client.join();
+
+    // "ERR no such city" / "ERR no route" answers are normal with random IDs, only
+    // dropped connections count as errors
+    cout << fixed << setprecision(1);
+    cout << "Reads:  " << reads << " (" << reads / static_cast<double>(seconds) << " queries/sec)\n";
+    printLatency("read latency", readLatency);
+    if (writers > 0) {
+        cout << "Writes: " << writes << " (" << writes / static_cast<double>(seconds) << " edits/sec)\n";
+        printLatency("write latency", writeLatency);
+        // Mostly add-road on a pair that already has a road, or a random ID that's gone
+        if (rejected > 0) cout << "Rejected edits (ERR): " << rejected << "\n";
+    }
+    if (errors > 0) cout << "Dropped connections: " << errors << "\n";
+    return errors > 0 ? 1 : 0;
+}
+#else
+int main() {
+    cout << "Error: The load generator needs server mode, which is not supported on Windows yet\n";
+    return 1;
+}
+#endif
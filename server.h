@@ -0,0 +1,242 @@
+// Server mode: lets many planners query the road network at once over a local
+// TCP connection (127.0.0.1 only), while an operator keeps editing it.
+//
+// Protocol: one request per line, fields split by commas like batch mode, and one
+// response line back starting with "OK" or "ERR". Cities can be an index or a name.
+//   lookup,Huye               -> OK 2,Huye
+//   route,Rusizi,Kigali       -> OK 202.80,7,2,3,1        (cost, then the city IDs on the way)
+//   connected,Rubavu,Rusizi   -> OK yes
+//   components                -> OK 1
+//   info                      -> OK <version>,<cities>,<roads>,<highest city ID>
+//   add-road,1,8  set-budget,1,8,45  rename-city,8,Karongi  add-city,Nyanza   -> OK <version>
+//   delete-road,1,8  delete-city,Nyanza                                       -> OK <version>
+//   quit (close this connection)   shutdown (stop the server)
+//
+// Readers work from an immutable GraphSnapshot grabbed with one atomic load, so they
+// never wait for writers and never see half an edit. Writers take turns on a mutex,
+// change the live CityGraph (journal and all), then publish a new snapshot.
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "city_graph.h" // The road network we're serving
+#include <mutex> // Writers take turns
+#include <condition_variable> // Idle workers wait for new connections
+#ifndef _WIN32
+#include <arpa/inet.h> // inet_pton for 127.0.0.1
+#include <netinet/in.h> // sockaddr_in
+#include <signal.h> // Ignore SIGPIPE when a client hangs up mid-answer
+#include <sys/socket.h> // socket, bind, listen, accept, send, recv
+#endif
+
+#ifndef _WIN32
+class QueryServer {
+private:
+    CityGraph &graph; // The live network, only touched while holding writeLock
+    mutex writeLock; // One writer at a time
+    shared_ptr<const GraphSnapshot> current; // What readers see; swapped atomically
+    uint64_t version = 0; // Version of the last published snapshot (under writeLock)
+    atomic<bool> running{true};
+    int listenSocket = -1;
+
+    mutex queueLock; // Guards waiting and serving
+    condition_variable queueReady; // Signals workers that a client is waiting
+    deque<int> waiting; // Accepted connections nobody is serving yet
+    vector<int> serving; // Connections a worker is busy with, so stop() can cut them off
+
+    // The latest snapshot; readers hold on to it for the whole request
+    shared_ptr<const GraphSnapshot> snapshot() const { return atomic_load(&current); }
+
+    // Make a fresh snapshot of the live graph and swap it in (call with writeLock held)
+    void publish() { atomic_store(&current, graph.makeSnapshot(++version)); }
+
+    // "3" or "Huye" -> city ID in this snapshot, -1 if there's no such city
+    static int resolve(const GraphSnapshot &view, const string &token) {
+        string text = trim(token);
+        int index;
+        auto [next, error] = from_chars(text.data(), text.data() + text.size(), index);
+        if (error == errc() && next == text.data() + text.size()) return view.hasCity(index) ? index : -1;
+        auto it = view.nameIndex.find(text);
+        return it == view.nameIndex.end() ? -1 : it->second;
+    }
+
+    // Read-only requests, answered from a snapshot without any locks
+    static string answerRead(const GraphSnapshot &view, const vector<string> &fields) {
+        const string &command = fields[0];
+        if (command == "info" && fields.size() == 1) {
+            return "OK " + to_string(view.version) + "," + to_string(view.nameIndex.size()) + "," +
+                   to_string(view.roads.targets.size() / 2) + "," + to_string(view.highestId);
+        }
+        if (command == "components" && fields.size() == 1) return "OK " + to_string(view.components);
+        if (command == "lookup" && fields.size() == 2) {
+            int city = resolve(view, fields[1]);
+            if (city == -1) return "ERR no such city";
+            return "OK " + to_string(city) + "," + view.names[city];
+        }
+        if ((command == "route" || command == "connected") && fields.size() == 3) {
+            int from = resolve(view, fields[1]), to = resolve(view, fields[2]);
+            if (from == -1 || to == -1) return "ERR no such city";
+            if (command == "connected") return view.component[from] == view.component[to] ? "OK yes" : "OK no";
+            if (view.component[from] != view.component[to]) return "ERR no route";
+            RouteTree tree = RouteEngine::cheapestFrom(view.roads, from, to);
+            ostringstream answer;
+            answer << "OK " << fixed << setprecision(2) << tree.cost[to];
+            for (int city : RouteEngine::pathTo(tree, to)) answer << "," << city;
+            return answer.str();
+        }
+        return "ERR unknown request";
+    }
+
+    // Edits: one writer at a time on the live graph, then publish a new snapshot
+    string answerWrite(const vector<string> &fields) {
+        lock_guard<mutex> lock(writeLock);
+        string error = graph.runCommand(fields);
+        if (!error.empty()) return "ERR " + error;
+        publish();
+        return "OK " + to_string(version);
+    }
+
+    static bool isWrite(const string &command) {
+        return command == "add-city" || command == "add-road" || command == "set-budget" || command == "rename-city" ||
+               command == "delete-city" || command == "delete-road";
+    }
+
+    // Send all of text, even if the socket takes it in pieces
+    static bool sendAll(int client, const string &text) {
+        size_t sent = 0;
+        while (sent < text.size()) {
+            ssize_t n = send(client, text.data() + sent, text.size() - sent, 0);
+            if (n <= 0) return false;
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    // Talk to one client until it says quit or hangs up
+    void serveClient(int client) {
+        string buffer;
+        char chunk[4096];
+        bool open = true;
+        while (open && running) {
+            ssize_t n = recv(client, chunk, sizeof(chunk), 0);
+            if (n <= 0) break;
+            buffer.append(chunk, static_cast<size_t>(n));
+            size_t start = 0, newline;
+            string replies; // Answer everything that arrived in one send
+            while ((newline = buffer.find('\n', start)) != string::npos) {
+                string line = trim(buffer.substr(start, newline - start));
+                start = newline + 1;
+                if (line.empty()) continue;
+                vector<string> fields = splitFields(line);
+                fields[0] = trim(fields[0]);
+                if (fields[0] == "quit") {
+                    open = false;
+                    break;
+                }
+                if (fields[0] == "shutdown") {
+                    stop();
+                    open = false;
+                    break;
+                }
+                replies += (isWrite(fields[0]) ? answerWrite(fields) : answerRead(*snapshot(), fields)) + "\n";
+            }
+            buffer.erase(0, start);
+            if (!replies.empty() && !sendAll(client, replies)) break;
+        }
+        {
+            // Off the list before closing, so stop() never shuts down a reused number
+            lock_guard<mutex> lock(queueLock);
+            serving.erase(find(serving.begin(), serving.end(), client));
+        }
+        close(client);
+    }
+
+    // Pool worker: take the next waiting connection and serve it
+    void workerLoop() {
+        while (true) {
+            int client;
+            {
+                unique_lock<mutex> lock(queueLock);
+                queueReady.wait(lock, [&] { return !waiting.empty() || !running; });
+                if (!running && waiting.empty()) return;
+                client = waiting.front();
+                waiting.pop_front();
+                serving.push_back(client);
+            }
+            serveClient(client);
+        }
+    }
+
+    void stop() {
+        running = false;
+        if (listenSocket != -1) shutdown(listenSocket, SHUT_RDWR); // Wakes up accept()
+        {
+            // Workers sitting in recv() on an idle client would never notice otherwise
+            lock_guard<mutex> lock(queueLock);
+            for (int client : serving) shutdown(client, SHUT_RDWR);
+        }
+        queueReady.notify_all();
+    }
+
+public:
+    explicit QueryServer(CityGraph &liveGraph) : graph(liveGraph) {}
+
+    // Listen on 127.0.0.1:port and serve with a pool of threadCount workers until
+    // someone sends "shutdown". Returns 0 when done, 1 if we couldn't start.
+    // Each worker serves one connection at a time, so keep clients <= threadCount.
+    int run(int port, unsigned threadCount) {
+        signal(SIGPIPE, SIG_IGN); // A client hanging up shouldn't kill the server
+        {
+            lock_guard<mutex> lock(writeLock);
+            publish();
+        }
+        listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+        if (listenSocket < 0) {
+            cout << "Error: Could not create a socket\n";
+            return 1;
+        }
+        int yes = 1;
+        setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        inet_pton(AF_INET, "127.0.0.1", &address.sin_addr); // Loopback only, not the whole network
+        if (bind(listenSocket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 ||
+            listen(listenSocket, 128) < 0) {
+            cout << "Error: Could not listen on 127.0.0.1:" << port << "\n";
+            close(listenSocket);
+            return 1;
+        }
+        threadCount = max(1u, threadCount);
+        cout << "Serving the road network on 127.0.0.1:" << port << " with " << threadCount
+             << " worker threads (send \"shutdown\" to stop)\n";
+        vector<thread> workers;
+        for (unsigned t = 0; t < threadCount; ++t) workers.emplace_back([this] { workerLoop(); });
+        while (running) {
+            int client = accept(listenSocket, nullptr, nullptr);
+            if (client < 0) continue; // Woken up by stop(), or a hiccup
+            {
+                lock_guard<mutex> lock(queueLock);
+                waiting.push_back(client);
+            }
+            queueReady.notify_one();
+        }
+        for (thread &worker : workers) worker.join();
+        for (int client : waiting) close(client);
+        close(listenSocket);
+        cout << "Server stopped at version " << version << "\n";
+        return 0;
+    }
+};
+#else
+// Windows sockets work differently (WSAStartup, closesocket), so no server there yet
+class QueryServer {
+public:
+    explicit QueryServer(CityGraph &) {}
+    int run(int, unsigned) {
+        cout << "Error: Server mode is not supported on Windows yet\n";
+        return 1;
+    }
+};
+#endif
+
+#endif // SERVER_H